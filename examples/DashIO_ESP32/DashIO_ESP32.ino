@@ -12,6 +12,7 @@
 
 #define TCP_PORT 5000
 #define MQTT_BUFFER_SIZE 2048
+#define OUTGOING_BUFFER_SIZE 512
 
 // WiFi
 #define WIFI_SSID "yourWiFiSSID"
@@ -79,7 +80,11 @@ const char *DIAL_ID = "DL01";
 const char* ntpServer = "pool.ntp.org";
 bool oneSecond = false; // Set by timer every second.
 int count = 0;
-String messageToSend = ((char *)0);
+
+// Messages for every connection are batched, and sent in one write per connection within 20ms of the first being added
+char outgoingBuffer[OUTGOING_BUFFER_SIZE];
+void sendOutgoingMessages(const char *messages, size_t length);
+MessageBatch outgoingMessages(outgoingBuffer, OUTGOING_BUFFER_SIZE, &sendOutgoingMessages);
 
 String getLocalTime() {
   struct tm dt; // dateTime
@@ -377,19 +382,16 @@ void processIncomingMessage(MessageData *connection) {
     }
 }
 
-void checkOutgoingMessages() {
-    if (messageToSend.length() > 0) {
+void sendOutgoingMessages(const char *messages, size_t length) {
 #ifndef NO_BLE
-        ble_con.sendMessage(messageToSend);
+    ble_con.sendMessage(messages, length);
 #endif
 #ifndef NO_TCP
-        tcp_con.sendMessage(messageToSend);
+    tcp_con.sendMessageToAll(messages, length);
 #endif
 #ifndef NO_MQTT
-        mqtt_con.sendMessage(messageToSend);
+    mqtt_con.sendMessage(messages, length);
 #endif
-        messageToSend = "";
-    }
 }
 
 void onProvisionCallback(ConnectionType connectionType, const String& message, bool commsChanged) {
@@ -413,8 +415,6 @@ void oneSecondTimerTask(void *parameters) {
 void setup() {
     Serial.begin(115200);
 
-    messageToSend.reserve(200);
-
     DeviceData defaultDeviceData = {DEVICE_NAME, WIFI_SSID, WIFI_PASSWORD, MQTT_USER, MQTT_PASSWORD};
     dashioProvision.load(&defaultDeviceData, &onProvisionCallback);
 
@@ -457,7 +457,7 @@ void loop() {
     ble_con.run();
 #endif
 
-    checkOutgoingMessages();
+    outgoingMessages.run();
 
     if (oneSecond) { // Tasks to occur every second
         oneSecond = false;
@@ -466,7 +466,7 @@ void loop() {
             count = 0;
         }
         if (count % 5 == 0) {
-            messageToSend = dashioDevice.getMapWaypointMessage(MAP_ID, "TX1", "-43.603488", "172.649536");
+            outgoingMessages.add(dashioDevice.getMapWaypointMessage(MAP_ID, "TX1", "-43.603488", "172.649536"));
         }
     }
 }
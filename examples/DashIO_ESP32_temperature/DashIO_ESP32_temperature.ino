@@ -90,6 +90,7 @@ void onProvisionCallback(ConnectionType connectionType, const String& message, b
     sendMessage(connectionType, message);
 
     if (commsChanged) {
+        dashioDevice.setConfigChanged(); // The MQTT connection config includes the user name
         mqtt_con.setup(dashioProvision.dashUserName, dashioProvision.dashPassword);
         wifi.begin(dashioProvision.wifiSSID, dashioProvision.wifiPassword);
     }
@@ -124,86 +125,84 @@ void processStatus(MessageData *messageData) {
     sendMessage(messageData->connectionType, message);
 }
 
-void processConfig1(MessageData *messageData) {
-    String message = dashioDevice.getConfigMessage(DeviceCfg(1, "name, wifi, dashio"));  // One device view
+// Config is built once and cached by dashioDevice, then sent in pages sized for each connection.
+// The Desc structs point at the literals instead of copying them into Strings.
+void buildConfig(MessageWriter& writer) {
+    dashioDevice.writeConfigMessage(writer, DeviceCfg(1, "name, wifi, dashio"));  // One device view
 
-    TextBoxCfg tempTextBox(TEMPTB_ID, CB01_ID, "Temperature", {0, 0, 1, 0.1515});
+    TextBoxDesc tempTextBox(TEMPTB_ID, CB01_ID, "Temperature", {0, 0, 1, 0.1515});
     tempTextBox.titlePosition = titleOff;
     tempTextBox.format = numFmt;
     tempTextBox.kbdType = noKbd;
     tempTextBox.units = "°C";
-    message += dashioDevice.getConfigMessage(tempTextBox);
+    dashioDevice.writeConfigMessage(writer, tempTextBox);
 
-    TimeGraphCfg tempGraph(GRAPH_ID, CB01_ID, "Temperature", {0, 0.1515, 1, 0.3636});
+    TimeGraphDesc tempGraph(GRAPH_ID, CB01_ID, "Temperature", {0, 0.1515, 1, 0.3636});
     tempGraph.titlePosition = titleOff;
     tempGraph.yAxisLabel = "°C";
     tempGraph.yAxisMin = 0;
     tempGraph.yAxisMax = 40;
     tempGraph.yAxisNumBars = 5;
-    message += dashioDevice.getConfigMessage(tempGraph);
+    dashioDevice.writeConfigMessage(writer, tempGraph);
 
-    LabelCfg labelHigh(LABEL_HIGH_ID, CB01_ID, "Max Temperature Alarm", {0, 0.5151, 1, 0.2424});
-    message += dashioDevice.getConfigMessage(labelHigh);
+    LabelDesc labelHigh(LABEL_HIGH_ID, CB01_ID, "Max Temperature Alarm", {0, 0.5151, 1, 0.2424});
+    dashioDevice.writeConfigMessage(writer, labelHigh);
 
-    ButtonCfg alarmEnableHighButton(AEB_HIGH_ID, CB01_ID, "Enable", {0.05, 0.5758, 0.25, 0.15});
+    ButtonDesc alarmEnableHighButton(AEB_HIGH_ID, CB01_ID, "Enable", {0.05, 0.5758, 0.25, 0.15});
     alarmEnableHighButton.titlePosition = titleOff;
     alarmEnableHighButton.iconName = "bell";
     alarmEnableHighButton.offColor = "red";
     alarmEnableHighButton.onColor = "lime";
-    message += dashioDevice.getConfigMessage(alarmEnableHighButton);
+    dashioDevice.writeConfigMessage(writer, alarmEnableHighButton);
 
-    TextBoxCfg alarmMaxTempTextBox(ALARMTB_HIGH_ID, CB01_ID, "Max °C", {0.35, 0.5758, 0.6, 0.1515});
+    TextBoxDesc alarmMaxTempTextBox(ALARMTB_HIGH_ID, CB01_ID, "Max °C", {0.35, 0.5758, 0.6, 0.1515});
     alarmMaxTempTextBox.titlePosition = titleOff;
     alarmMaxTempTextBox.format = numFmt;
     alarmMaxTempTextBox.precision = 3;
     alarmMaxTempTextBox.kbdType = numKbd;
     alarmMaxTempTextBox.units = "°C";
-    message += dashioDevice.getConfigMessage(alarmMaxTempTextBox);
-    sendMessage(messageData->connectionType, message);
-}
+    dashioDevice.writeConfigMessage(writer, alarmMaxTempTextBox);
 
-void processConfig2(MessageData *messageData) {
-    LabelCfg labelLow(LABEL_LOW_ID, CB01_ID, "Min Temperature Alarm", {0, 0.7576, 1, 0.2424});
-    String message = dashioDevice.getConfigMessage(labelLow);
+    LabelDesc labelLow(LABEL_LOW_ID, CB01_ID, "Min Temperature Alarm", {0, 0.7576, 1, 0.2424});
+    dashioDevice.writeConfigMessage(writer, labelLow);
 
-    ButtonCfg alarmEnableLowButton(AEB_LOW_ID, CB01_ID, "Enable", {0.05, 0.8181, 0.25, 0.15});
+    ButtonDesc alarmEnableLowButton(AEB_LOW_ID, CB01_ID, "Enable", {0.05, 0.8181, 0.25, 0.15});
     alarmEnableLowButton.titlePosition = titleOff;
     alarmEnableLowButton.iconName = "bell";
     alarmEnableLowButton.offColor = "red";
     alarmEnableLowButton.onColor = "lime";
-    message += dashioDevice.getConfigMessage(alarmEnableLowButton);
+    dashioDevice.writeConfigMessage(writer, alarmEnableLowButton);
 
-    TextBoxCfg alarmMinTempTextBox(ALARMTB_LOW_ID, CB01_ID, "Max °C", {0.35, 0.8181, 0.6, 0.1515});
+    TextBoxDesc alarmMinTempTextBox(ALARMTB_LOW_ID, CB01_ID, "Max °C", {0.35, 0.8181, 0.6, 0.1515});
     alarmMinTempTextBox.titlePosition = titleOff;
     alarmMinTempTextBox.format = numFmt;
     alarmMinTempTextBox.precision = 3;
     alarmMinTempTextBox.kbdType = numKbd;
     alarmMinTempTextBox.units = "°C";
-    message += dashioDevice.getConfigMessage(alarmMinTempTextBox);
+    dashioDevice.writeConfigMessage(writer, alarmMinTempTextBox);
     
     // Connections
     BLEConnCfg bleCnctnConfig(SERVICE_UUID, CHARACTERISTIC_UUID, CHARACTERISTIC_UUID);
-    message += dashioDevice.getConfigMessage(bleCnctnConfig);
+    dashioDevice.writeConfigMessage(writer, bleCnctnConfig);
   
     MQTTConnCfg mqttCnctnConfig(dashioProvision.dashUserName, DASH_SERVER);
-    message += dashioDevice.getConfigMessage(mqttCnctnConfig);
+    dashioDevice.writeConfigMessage(writer, mqttCnctnConfig);
 
-    AlarmCfg alarmHighCfg("AL02", "Over Temperature", "boing");
-    message += dashioDevice.getConfigMessage(alarmHighCfg);
+    AlarmDesc alarmHighCfg("AL02", "Over Temperature", "boing");
+    dashioDevice.writeConfigMessage(writer, alarmHighCfg);
 
-    AlarmCfg alarmLowCfg("AL01", "Under Temperature", "boing");
-    message += dashioDevice.getConfigMessage(alarmLowCfg);
+    AlarmDesc alarmLowCfg("AL01", "Under Temperature", "boing");
+    dashioDevice.writeConfigMessage(writer, alarmLowCfg);
 
     // Device View
-    DeviceViewCfg deviceView(CB01_ID, "Temperature Log", "Termperature", "16");
+    DeviceViewDesc deviceView(CB01_ID, "Temperature Log", "Termperature", "16");
     deviceView.ctrlMaxFontSize = 45;
-    deviceView.color = 16;
+    deviceView.color = "16";
     deviceView.ctrlColor = "white";
     deviceView.ctrlBorderColor = "white";
     deviceView.ctrlBkgndColor = "blue";
-    deviceView.ctrlTitleBoxColor = 5;
-    message += dashioDevice.getConfigMessage(deviceView);
-    sendMessage(messageData->connectionType, message);
+    deviceView.ctrlTitleBoxColor = "5";
+    dashioDevice.writeConfigMessage(writer, deviceView);
 }
 
 void processButton(MessageData *messageData) {
@@ -245,10 +244,6 @@ void processIncomingMessage(MessageData *messageData) {
     case status:
         processStatus(messageData);
         break;
-    case config:
-        processConfig1(messageData);
-        processConfig2(messageData);
-        break;
     case textBox:
         processTextBox(messageData);
         break;
@@ -344,6 +339,7 @@ void setup() {
     dashioProvision.load(&defaultDeviceData, &onProvisionCallback);
 
     dashioDevice.setup(wifi.macAddress()); // unique deviceID
+    dashioDevice.setConfigBuilder(&buildConfig);
     
     ble_con.setCallback(&processIncomingMessage);
     ble_con.begin();
@@ -381,7 +381,7 @@ void processIncomingMessage(MessageData *messageData) {
 void checkOutgoingMessages() {
     if (messageToSend.length() > 0) {
 #ifndef NO_TCP
-        tcp_con.sendMessage(messageToSend);
+        tcp_con.sendMessageToAll(messageToSend);
 #endif
 #ifndef NO_MQTT
         mqtt_con.sendMessage(messageToSend);
@@ -87,14 +87,15 @@ void DashioBluefruit_BLE::begin(bool factoryResetEnable, bool useMacForDeviceID)
         // Get deviceID for mac address
         bluefruit.println("AT+BLEGETADDR");
         delay(1000); // Wait a while for reply
-        dashioDevice->deviceID = "";
+        String macStr((char *)0);
         while(bluefruit.available() > 0) {
             char c = bluefruit.read();
             if ((c == '\n') || (c == '\r')) { // Before the OK
                 break;
             }
-            dashioDevice->deviceID += c;
+            macStr += c;
         }
+        dashioDevice->setup(macStr);
         Serial.print(F("DeviceID: "));
         Serial.println(dashioDevice->deviceID);
     }
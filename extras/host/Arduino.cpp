@@ -0,0 +1,179 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+
+unsigned long millis() {
+    static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer) {
+    sprintf(buffer, "%*.*f", width, precision, value);
+    return buffer;
+}
+
+// ---------------------------------------- String -------------------------------------
+
+static std::string formatInteger(unsigned long magnitude, bool negative, unsigned char base) {
+    char digits[sizeof(unsigned long) * 8 + 2];
+    char *digit = digits + sizeof(digits) - 1;
+    *digit = '\0';
+    do {
+        *--digit = "0123456789abcdef"[magnitude % base];
+        magnitude /= base;
+    } while (magnitude > 0);
+    if (negative) {
+        *--digit = '-';
+    }
+    return digit;
+}
+
+String::String(const char *text) {
+    if (text != NULL) {
+        str = text;
+    }
+}
+
+String::String(const __FlashStringHelper *text) : String((const char *)text) {}
+
+String::String(char chr) : str(1, chr) {}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) {
+    if ((base == DEC) && (value < 0)) {
+        str = formatInteger(0UL - (unsigned long)value, true, base);
+    } else {
+        str = formatInteger((unsigned long)value, false, base);
+    }
+}
+
+String::String(unsigned long value, unsigned char base) : str(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned char decimalPlaces) : String((double)value, decimalPlaces) {}
+
+String::String(double value, unsigned char decimalPlaces) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    str = buffer;
+}
+
+int String::indexOf(char chr, unsigned int fromIndex) const {
+    size_t index = str.find(chr, fromIndex);
+    return (index == std::string::npos) ? -1 : (int)index;
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, str.length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        std::swap(beginIndex, endIndex);
+    }
+    endIndex = std::min(endIndex, (unsigned int)str.length());
+    if (beginIndex >= endIndex) {
+        return String();
+    }
+    String result;
+    result.str = str.substr(beginIndex, endIndex - beginIndex);
+    return result;
+}
+
+void String::remove(unsigned int index) {
+    if (index < str.length()) {
+        str.erase(index);
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < str.length()) {
+        str.erase(index, count);
+    }
+}
+
+void String::toCharArray(char *buffer, unsigned int bufferSize) const {
+    if (bufferSize == 0) {
+        return;
+    }
+    size_t copyLength = std::min((size_t)bufferSize - 1, str.length());
+    memcpy(buffer, str.c_str(), copyLength);
+    buffer[copyLength] = '\0';
+}
+
+String operator+(const String& left, const String& right) {
+    String result(left);
+    result.concat(right);
+    return result;
+}
+
+String operator+(const String& left, const char *right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, char right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, int right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, unsigned int right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, long right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, unsigned long right) {
+    return left + String(right);
+}
+
+String operator+(const String& left, const __FlashStringHelper *right) {
+    return left + String(right);
+}
+
+// ---------------------------------------- Print --------------------------------------
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+    size_t written = 0;
+    while ((written < size) && (write(buffer[written]) == 1)) {
+        written++;
+    }
+    return written;
+}
@@ -0,0 +1,164 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// The parts of the Arduino core the library uses, for building the POSIX transports on a Linux or macOS host.
+// Only what DashIO needs is here. Serial writes to stdout and millis() counts from the first time it is called.
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::min;
+using std::max;
+
+// No separate flash memory on a host, so flash strings are ordinary strings
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char *PGM_P;
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_ptr(address) (*(void * const *)(address))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define memcpy_P memcpy
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+void delay(unsigned long ms);
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer);
+
+class String {
+public:
+    String(const char *text = "");
+    String(const __FlashStringHelper *text);
+    String(char chr);
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+    String(float value, unsigned char decimalPlaces = 2);
+    String(double value, unsigned char decimalPlaces = 2);
+
+    bool reserve(unsigned int size) { str.reserve(size); return true; }
+    unsigned int length() const { return str.length(); }
+    const char *c_str() const { return str.c_str(); }
+
+    bool concat(const String& text) { str += text.str; return true; }
+    bool concat(const char *text) { str += text; return true; }
+    bool concat(const char *text, unsigned int textLength) { str.append(text, textLength); return true; }
+    bool concat(char chr) { str += chr; return true; }
+    String& operator+=(const String& text) { concat(text); return *this; }
+    String& operator+=(const char *text) { concat(text); return *this; }
+    String& operator+=(char chr) { concat(chr); return *this; }
+    String& operator+=(int value) { concat(String(value)); return *this; }
+    String& operator+=(unsigned int value) { concat(String(value)); return *this; }
+    String& operator+=(long value) { concat(String(value)); return *this; }
+    String& operator+=(unsigned long value) { concat(String(value)); return *this; }
+    String& operator+=(const __FlashStringHelper *text) { concat(String(text)); return *this; }
+
+    bool equals(const String& text) const { return str == text.str; }
+    bool operator==(const String& text) const { return str == text.str; }
+    bool operator==(const char *text) const { return str == text; }
+    bool operator!=(const String& text) const { return str != text.str; }
+    bool operator!=(const char *text) const { return str != text; }
+
+    char charAt(unsigned int index) const { return (index < str.length()) ? str[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return str[index]; }
+    int indexOf(char chr, unsigned int fromIndex = 0) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+    void remove(unsigned int index);
+    void remove(unsigned int index, unsigned int count);
+    long toInt() const { return atol(str.c_str()); }
+    float toFloat() const { return atof(str.c_str()); }
+    void toCharArray(char *buffer, unsigned int bufferSize) const;
+    void getBytes(unsigned char *buffer, unsigned int bufferSize) const { toCharArray((char *)buffer, bufferSize); }
+
+private:
+    std::string str;
+};
+
+String operator+(const String& left, const String& right);
+String operator+(const String& left, const char *right);
+String operator+(const String& left, char right);
+String operator+(const String& left, int right);
+String operator+(const String& left, unsigned int right);
+String operator+(const String& left, long right);
+String operator+(const String& left, unsigned long right);
+String operator+(const String& left, const __FlashStringHelper *right);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t chr) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+
+    size_t print(const __FlashStringHelper *text) { return write((const char *)text); }
+    size_t print(const String& text) { return write(text.c_str(), text.length()); }
+    size_t print(const char *text) { return write(text); }
+    size_t print(char chr) { return write((uint8_t)chr); }
+    size_t print(int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+    size_t print(double value, int digits = 2) { return print(String(value, digits)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t chr) { return fwrite(&chr, 1, 1, stdout); }
+    size_t write(const uint8_t *buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Heap allocations made while encoding messages.
+//   alloc_benchmark [messages]
+// Every operator new is counted. Each message is encoded with its write method into a MessageWriter on the stack,
+// then with the matching String returning get method, and the allocations per message and time per message of each
+// are printed. The write methods should make no allocations at all.
+
+#include "Arduino.h"
+#include "DashIO.h"
+#include <chrono>
+#include <new>
+
+static unsigned long allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *memory = malloc(size ? size : 1);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+    free(memory);
+}
+
+DashioDevice dashioDevice("alloc_benchmark");
+
+const int GRAPH_POINTS = 8;
+int graphInts[GRAPH_POINTS] = {10, 20, 35, 50, 45, 30, 25, 15};
+float graphFloats[GRAPH_POINTS] = {1.5, 2.25, 3.125, 4.0, 3.5, 2.75, 2.0, 1.25};
+
+// Encodes the same mix of messages as getMessages, into the writer
+static int writeMessages(MessageWriter& writer, const LabelCfg& labelCfg) {
+    dashioDevice.writeButtonMessage(writer, "B1", true, "bulb", "On");
+    dashioDevice.writeTextBoxMessage(writer, "TB1", "21.5 C");
+    dashioDevice.writeSliderMessage(writer, "S1", 42);
+    dashioDevice.writeKnobMessage(writer, "K1", 12.75f);
+    dashioDevice.writeDoubleBarMessage(writer, "DB1", 3, 97);
+    dashioDevice.writeGraphLineInts(writer, "G1", "L1", "Ints", line, "red", graphInts, GRAPH_POINTS);
+    dashioDevice.writeGraphLineFloats(writer, "G1", "L2", "Floats", bar, "blue", graphFloats, GRAPH_POINTS);
+    dashioDevice.writeTimeGraphPoint(writer, "TG1", "L1", 19.25f);
+    dashioDevice.writeConfigMessage(writer, labelCfg);
+    return 9;
+}
+
+static int getMessages(String messages[], const LabelCfg& labelCfg) {
+    messages[0] = dashioDevice.getButtonMessage("B1", true, "bulb", "On");
+    messages[1] = dashioDevice.getTextBoxMessage("TB1", "21.5 C");
+    messages[2] = dashioDevice.getSliderMessage("S1", 42);
+    messages[3] = dashioDevice.getKnobMessage("K1", 12.75f);
+    messages[4] = dashioDevice.getDoubleBarMessage("DB1", 3, 97);
+    messages[5] = dashioDevice.getGraphLineInts("G1", "L1", "Ints", line, "red", graphInts, GRAPH_POINTS);
+    messages[6] = dashioDevice.getGraphLineFloats("G1", "L2", "Floats", bar, "blue", graphFloats, GRAPH_POINTS);
+    messages[7] = dashioDevice.getTimeGraphPoint("TG1", "L1", 19.25f);
+    messages[8] = dashioDevice.getConfigMessage(labelCfg);
+    return 9;
+}
+
+static void printResult(const char *name, long numMessages, unsigned long numAllocations, double seconds) {
+    printf("%-28s %10lu allocs  %8.2f allocs/msg  %8.1f ns/msg\n", name, numAllocations, (double)numAllocations / numMessages, seconds * 1e9 / numMessages);
+}
+
+int main(int argc, char *argv[]) {
+    long numRounds = ((argc > 1) ? atol(argv[1]) : 1000000) / 9;
+    if (numRounds < 1) {
+        printf("Usage: %s [messages, at least 9]\n", argv[0]);
+        return 1;
+    }
+    dashioDevice.setup("alloc:bench", "Alloc Benchmark");
+    LabelCfg labelCfg("L1", "DV1", "Temperature");
+    String messages[9];
+
+    char buffer[1024];
+    size_t encodedLength = 0;
+    long numMessages = 0;
+    unsigned long startAllocations = allocations;
+    auto startTime = std::chrono::steady_clock::now();
+    for (long i = 0; i < numRounds; i++) {
+        MessageWriter writer(buffer, sizeof(buffer));
+        numMessages += writeMessages(writer, labelCfg);
+        encodedLength += writer.length();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printResult("write* into MessageWriter", numMessages, allocations - startAllocations, seconds);
+
+    numMessages = 0;
+    startAllocations = allocations;
+    startTime = std::chrono::steady_clock::now();
+    for (long i = 0; i < numRounds; i++) {
+        numMessages += getMessages(messages, labelCfg);
+        encodedLength += messages[0].length();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printResult("get* returning String", numMessages, allocations - startAllocations, seconds);
+
+    printf("encoded %zu bytes\n", encodedLength);
+    return 0;
+}
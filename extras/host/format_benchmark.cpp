@@ -0,0 +1,125 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Time per call of the number formatters, and of the String getters that use them.
+//   format_benchmark [calls]
+// formatFloat and formatInt are timed against the sprintf, dtostrf and String based formatting that the library used
+// before them, which is copied below. The values cover the fixed point and exponent ranges, and negatives.
+// On a host, dtostrf is the sprintf in Arduino.cpp, so its time only stands in for the AVR one.
+
+#include "Arduino.h"
+#include "DashIO.h"
+#include <chrono>
+#include <limits.h>
+
+const int NUM_VALUES = 16;
+const float FLOAT_VALUES[NUM_VALUES] = {0.0f, 1.0f, -1.5f, 3.14159f, 21.5f, -40.25f, 99.999f, 1234.5f,
+                                        -9876.54f, 65535.0f, 0.25f, -0.0125f, 123456.0f, 2.5e7f, 1.0e-5f, 42.0f};
+const long INT_VALUES[NUM_VALUES] = {0, 1, -1, 7, 42, -99, 100, 1000,
+                                     -32768, 65535, 123456, -1234567, 2147483647L, -2147483647L, 10, 255};
+
+DashioDevice dashioDevice("format_benchmark");
+volatile size_t checksum = 0; // Keeps the results live, so the compiler can't drop the calls
+
+// The formatting the library used before formatFloat and formatInt
+static String oldFormatFloat(float value) {
+    if (value == INVALID_FLOAT_VALUE) {
+        return "nan";
+    } else if (abs(value) < SMALLEST_FLOAT_VALUE) {
+        return "0";
+    }
+
+    char buffer[16];
+    if ((abs(value) < 1.0) || (abs(value) >= 100000)) {
+        sprintf(buffer, "%5.2e", value);
+    } else {
+        sprintf(buffer, "%5.2f", value);
+    }
+    return buffer;
+}
+
+static String oldFormatFloatAVR(float value) {
+    if (value == INVALID_FLOAT_VALUE) {
+        return "nan";
+    } else if (abs(value) < SMALLEST_FLOAT_VALUE) {
+        return "0";
+    }
+
+    char buffer[16];
+    dtostrf(value, 5, 2, buffer);
+    return buffer;
+}
+
+static String oldFormatInt(int value) {
+    if (value == INVALID_INT_VALUE) {
+        return "nan";
+    } else {
+        return String(value);
+    }
+}
+
+// Calls format with each value in turn, and prints the time per call
+template <typename Format>
+static void timeFormat(const char *name, long numCalls, Format format) {
+    auto startTime = std::chrono::steady_clock::now();
+    for (long i = 0; i < numCalls; i++) {
+        checksum += format(i % NUM_VALUES);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    printf("%-36s %8.1f ns/call\n", name, seconds * 1e9 / numCalls);
+}
+
+int main(int argc, char *argv[]) {
+    long numCalls = (argc > 1) ? atol(argv[1]) : 4000000;
+    if (numCalls < NUM_VALUES) {
+        printf("Usage: %s [calls, at least %d]\n", argv[0], NUM_VALUES);
+        return 1;
+    }
+    dashioDevice.setup("format:bench", "Format Benchmark");
+    char buffer[FORMAT_BUFFER_SIZE];
+
+    timeFormat("formatFloat into a buffer", numCalls, [&](int i) {
+        return formatFloat(buffer, FLOAT_VALUES[i]);
+    });
+    timeFormat("old sprintf formatFloat to String", numCalls, [&](int i) {
+        return oldFormatFloat(FLOAT_VALUES[i]).length();
+    });
+    timeFormat("old dtostrf formatFloat to String", numCalls, [&](int i) {
+        return oldFormatFloatAVR(FLOAT_VALUES[i]).length();
+    });
+    timeFormat("formatInt into a buffer", numCalls, [&](int i) {
+        return formatInt(buffer, INT_VALUES[i]);
+    });
+    timeFormat("old formatInt to String", numCalls, [&](int i) {
+        return oldFormatInt((int)INT_VALUES[i]).length();
+    });
+    timeFormat("getSliderMessage(float)", numCalls, [&](int i) {
+        return dashioDevice.getSliderMessage("S1", FLOAT_VALUES[i]).length();
+    });
+    timeFormat("getButtonMessage", numCalls, [&](int i) {
+        return dashioDevice.getButtonMessage("B1", (i & 1) != 0).length();
+    });
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Messages per second through DashioGateway against the number of devices it hosts.
+//   gateway_benchmark [messages]
+// For 1, 10, 100 and 1000 devices, one dashboard on a loopback socket sends button presses spread across all of the
+// devices, and each device answers. The same messages are then passed in as MQTT publishes of 10 messages each.
+
+#include "Arduino.h"
+#include "DashioGateway.h"
+#include "DashioSocket.h"
+#include <chrono>
+#include <string>
+
+const uint16_t BENCHMARK_PORT = 47001;
+const int DEVICE_COUNTS[] = {1, 10, 100, 1000};
+const int MESSAGES_PER_PUBLISH = 10;
+
+DashioGateway gateway(BENCHMARK_PORT);
+DashioDevice *devices[1000];
+unsigned long messagesHandled = 0;
+
+void processIncomingMessage(DashioDevice *device, MessageData *messageData) {
+    messagesHandled++;
+    if (messageData->control == button) {
+        gateway.sendReply(device->getButtonMessage(messageData->idStr, true));
+    }
+}
+
+void mqttPublish(const String&, const char *, size_t) { // The benchmark only times routing, so publishes go nowhere
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point startTime) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Button presses for every device in turn, so that routing has to find a different device for each message
+static std::string buttonMessages(int numDevices, int numMessages) {
+    std::string messages;
+    for (int i = 0; i < numMessages; i++) {
+        messages += "\t";
+        messages += devices[i % numDevices]->deviceID.c_str();
+        messages += "\tBTTN\tB1\n";
+    }
+    return messages;
+}
+
+static double tcpMessagesPerSecond(int numDevices, long numMessages) {
+    int clientSocket = socketConnect("127.0.0.1", BENCHMARK_PORT);
+    if (clientSocket < 0) {
+        return 0;
+    }
+    for (int tries = 0; (tries < 1000) && (gateway.numClients() == 0); tries++) {
+        gateway.run(1);
+    }
+
+    std::string burst = buttonMessages(numDevices, 1000);
+    long totalBytes = (numMessages / 1000) * (long)burst.length();
+    long sentBytes = 0;
+    static char replies[65536];
+    messagesHandled = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    while (messagesHandled < (unsigned long)(numMessages / 1000) * 1000) {
+        if (sentBytes < totalBytes) {
+            size_t burstStart = sentBytes % burst.length();
+            long sent = socketSend(clientSocket, burst.data() + burstStart, burst.length() - burstStart);
+            if (sent > 0) {
+                sentBytes += sent;
+            }
+        }
+        gateway.run(0);
+        while (socketReceive(clientSocket, replies, sizeof(replies)) > 0) {
+        }
+    }
+    double seconds = secondsSince(startTime);
+
+    socketClose(clientSocket);
+    for (int tries = 0; (tries < 100) && (gateway.numClients() > 0); tries++) {
+        gateway.run(1);
+    }
+    return messagesHandled / seconds;
+}
+
+static double mqttMessagesPerSecond(int numDevices, long numMessages) {
+    std::string publish = buttonMessages(numDevices, MESSAGES_PER_PUBLISH);
+    messagesHandled = 0;
+    auto startTime = std::chrono::steady_clock::now();
+    for (long i = 0; i < numMessages / MESSAGES_PER_PUBLISH; i++) {
+        gateway.processMQTTMessage("benchmark/gateway/control", publish.data(), publish.length());
+    }
+    return messagesHandled / secondsSince(startTime);
+}
+
+int main(int argc, char *argv[]) {
+    long numMessages = (argc > 1) ? atol(argv[1]) : 1000000;
+    if (numMessages < 1000) {
+        printf("Usage: %s [messages, at least 1000]\n", argv[0]);
+        return 1;
+    }
+
+    gateway.setMQTT("benchmark", &mqttPublish);
+    if (!gateway.begin()) {
+        printf("Can't listen on port %u\n", BENCHMARK_PORT);
+        return 1;
+    }
+
+    printf("devices     TCP msg/s    MQTT msg/s\n");
+    int numDevices = 0;
+    for (int deviceCount : DEVICE_COUNTS) {
+        for (; numDevices < deviceCount; numDevices++) {
+            char deviceID[16];
+            snprintf(deviceID, sizeof(deviceID), "sensor%04d", numDevices);
+            devices[numDevices] = new DashioDevice("gateway_benchmark");
+            devices[numDevices]->setup(deviceID, deviceID);
+            gateway.addDevice(devices[numDevices], &processIncomingMessage);
+        }
+        double tcpRate = tcpMessagesPerSecond(numDevices, numMessages);
+        double mqttRate = mqttMessagesPerSecond(numDevices, numMessages);
+        printf("%7d  %12.0f  %12.0f\n", numDevices, tcpRate, mqttRate);
+    }
+    printf("routed %lu  unknown device %lu  dropped %u\n", gateway.messagesRouted, gateway.unknownDeviceMessages, gateway.droppedMessages);
+    gateway.end();
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Drives the host DashioTCP over loopback sockets, without hardware.
+//   tcp_loadtest [clients] [messages]   Each client sends button presses as fast as the device takes them, and the
+//                                       device answers each one. Prints the messages per second handled.
+//   tcp_loadtest --replay session.txt   Sends a recorded dashboard session, i.e. the bytes a dashboard sent, to the
+//                                       device and prints what the device received and sent.
+
+#include "Arduino.h"
+#include "DashioPOSIX.h"
+#include "DashioSocket.h"
+#include <chrono>
+#include <string>
+
+const uint16_t LOADTEST_PORT = 47000;
+const int REPLAY_QUIET_MS = 200; // A replay is finished once the device has sent nothing for this long
+
+DashioDevice dashioDevice("host_loadtest");
+DashioTCP *tcp;
+unsigned long messagesHandled = 0;
+
+// Every message is counted. Button presses get a reply, so the send path is loaded too
+void processIncomingMessage(MessageData *messageData) {
+    messagesHandled++;
+    if (messageData->control == button) {
+        tcp->sendMessage(dashioDevice.getButtonMessage(messageData->idStr, true), tcp->currentClient);
+    }
+}
+
+// Reads and discards whatever has arrived, and returns how much it was
+static long drain(int clientSocket) {
+    static char buffer[65536];
+    long total = 0;
+    long received;
+    while ((received = socketReceive(clientSocket, buffer, sizeof(buffer))) > 0) {
+        total += received;
+    }
+    return total;
+}
+
+// Connects the clients and waits until the device has accepted them all
+static bool connectClients(int clientSockets[], int numClients) {
+    for (int i = 0; i < numClients; i++) {
+        clientSockets[i] = socketConnect("127.0.0.1", LOADTEST_PORT);
+        if (clientSockets[i] < 0) {
+            printf("Can't connect to port %u\n", LOADTEST_PORT);
+            return false;
+        }
+    }
+    for (int tries = 0; (tries < 1000) && (tcp->numClients() < numClients); tries++) {
+        tcp->run();
+        delay(1);
+    }
+    return tcp->numClients() == numClients;
+}
+
+static int loadTest(int numClients, long numMessages) {
+    int clientSockets[TCP_MAX_CLIENTS];
+    if (!connectClients(clientSockets, numClients)) {
+        return 1;
+    }
+
+    std::string message = std::string("\t") + dashioDevice.deviceID.c_str() + "\tBTTN\tB1\n";
+    long messagesPerClient = numMessages / numClients;
+    std::string burst;
+    for (int i = 0; i < 1000; i++) {
+        burst += message;
+    }
+
+    long sentBytes[TCP_MAX_CLIENTS] = {0};
+    long replyBytes = 0;
+    long totalBytes = messagesPerClient * (long)message.length();
+    unsigned long expected = messagesPerClient * numClients;
+    auto startTime = std::chrono::steady_clock::now();
+    while (messagesHandled < expected) {
+        for (int i = 0; i < numClients; i++) {
+            if (sentBytes[i] < totalBytes) {
+                size_t burstStart = sentBytes[i] % burst.length();
+                size_t sendLength = std::min((long)(burst.length() - burstStart), totalBytes - sentBytes[i]);
+                long sent = socketSend(clientSockets[i], burst.data() + burstStart, sendLength);
+                if (sent > 0) {
+                    sentBytes[i] += sent;
+                }
+            }
+        }
+        tcp->run();
+        for (int i = 0; i < numClients; i++) {
+            replyBytes += drain(clientSockets[i]);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    printf("clients %d  messages %lu  %.3f s  %.0f msg/s\n", numClients, messagesHandled, seconds, messagesHandled / seconds);
+    printf("reply bytes %ld  sent %lu  dropped %u  socket writes %lu\n", replyBytes, tcp->messagesSent, tcp->droppedMessages, tcp->segmentsSent);
+    for (int i = 0; i < numClients; i++) {
+        socketClose(clientSockets[i]);
+    }
+    return 0;
+}
+
+static int replay(const char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) {
+        printf("Can't open %s\n", fileName);
+        return 1;
+    }
+    std::string session;
+    char buffer[4096];
+    size_t readLength;
+    while ((readLength = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        session.append(buffer, readLength);
+    }
+    fclose(file);
+
+    int clientSocket;
+    if (!connectClients(&clientSocket, 1)) {
+        return 1;
+    }
+
+    size_t sent = 0;
+    unsigned long lastReplyTime = millis();
+    while ((sent < session.length()) || (millis() - lastReplyTime < REPLAY_QUIET_MS)) {
+        if (sent < session.length()) {
+            long sentNow = socketSend(clientSocket, session.data() + sent, session.length() - sent);
+            if (sentNow > 0) {
+                sent += sentNow;
+            }
+        }
+        tcp->run();
+        if (drain(clientSocket) > 0) {
+            lastReplyTime = millis();
+        }
+        delay(1);
+    }
+    printf("replayed %zu bytes, %lu messages\n", session.length(), messagesHandled);
+    socketClose(clientSocket);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    bool replaying = (argc == 3) && (strcmp(argv[1], "--replay") == 0);
+    dashioDevice.setup("loadtest", "Load Test");
+    DashioTCP tcpConnection(&dashioDevice, LOADTEST_PORT, replaying); // Replays print every message
+    tcp = &tcpConnection;
+    tcp->setCallback(&processIncomingMessage);
+    if (!tcp->begin()) {
+        printf("Can't listen on port %u\n", LOADTEST_PORT);
+        return 1;
+    }
+
+    if (replaying) {
+        return replay(argv[2]);
+    }
+    int numClients = (argc > 1) ? atoi(argv[1]) : 4;
+    long numMessages = (argc > 2) ? atol(argv[2]) : 1000000;
+    if ((numClients < 1) || (numClients > TCP_MAX_CLIENTS) || (numMessages < numClients)) {
+        printf("Usage: %s [clients 1-%d] [messages], or %s --replay session.txt\n", argv[0], TCP_MAX_CLIENTS, argv[0]);
+        return 1;
+    }
+    return loadTest(numClients, numMessages);
+}
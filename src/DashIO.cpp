@@ -56,6 +56,8 @@
 #define COLOR_ID "CLR"
 #define AV_ID "AVD"
 #define BASIC_CONFIG_ID "BAS"
+#define CONFIG_UNCHANGED_ID "UNCHANGED"
+#define BROADCAST_ID "BRDCST"
 
 #define DEVICE_NAME_ID "NAME"
 #define WIFI_SETUP_ID "WIFI"
@@ -90,157 +92,308 @@
 #define WILL_TOPIC_TIP     "data"
 
 // MQTT basic messages
-#define MQTT_ONLINE_MSSG  "\tONLINE\n"
-#define MQTT_OFFLINE_MSSG "\tOFFLINE\n"
+#define MQTT_ONLINE_ID  "ONLINE"
+#define MQTT_OFFLINE_ID "OFFLINE"
 
-#define MAX_STRING_LEN 64
+#define SHORT_MESSAGE_LEN 48 // Delimiters, message and control types and numbers of a short message, without its text
+#define TRACK_DEGREES_DECIMALS 6 // TrackPoint latitude and longitude are in millionths of a degree
 #define MAX_DEVICE_NAME_LEN 32
 #define MAX_DEVICE_TYPE_LEN 32
 
 char DASH_SERVER[] = "dash.dashio.io";
 
-const char END_DELIM = '\n';
-const char DELIM = '\t';
+// Wire IDs in ControlType order, used for both sending and receiving.
+// Received is set for the IDs that a device can receive. MQTT and TCP are shared by setup and connection types.
+struct ControlTypeInfo {
+    const char *id;
+    uint8_t idLength;
+    bool received;
+};
+
+#define CONTROL_TYPE_INFO(id, received) {id, sizeof(id) - 1, received}
+
+static const ControlTypeInfo controlTypes[] = {
+    CONTROL_TYPE_INFO(WHO_ID, true),                // who
+    CONTROL_TYPE_INFO(CONNECT_ID, true),            // connect
+    CONTROL_TYPE_INFO(STATUS_ID, true),             // status
+    CONTROL_TYPE_INFO(CONFIG_ID, true),             // config
+    CONTROL_TYPE_INFO("", false),                   // pushToken
+    CONTROL_TYPE_INFO(MQTT_CONNECTION_ID, false),   // mqttConn
+    CONTROL_TYPE_INFO(BLE_CONNECTION_ID, false),    // bleConn
+    CONTROL_TYPE_INFO(TCP_CONNECTION_ID, false),    // tcpConn
+    CONTROL_TYPE_INFO(ALARM_ID, false),             // alarmNotify
+    CONTROL_TYPE_INFO(DEVICE_ID, false),            // device
+    CONTROL_TYPE_INFO(DEVICE_VIEW_ID, false),       // deviceView
+    CONTROL_TYPE_INFO(LABEL_ID, false),             // label
+    CONTROL_TYPE_INFO(BUTTON_ID, true),             // button
+    CONTROL_TYPE_INFO(MENU_ID, true),               // menu
+    CONTROL_TYPE_INFO(BUTTON_GROUP_ID, true),       // buttonGroup
+    CONTROL_TYPE_INFO(EVENT_LOG_ID, true),          // eventLog
+    CONTROL_TYPE_INFO(SLIDER_ID, true),             // slider
+    CONTROL_TYPE_INFO(KNOB_ID, true),               // knob
+    CONTROL_TYPE_INFO(DIAL_ID, false),              // dial
+    CONTROL_TYPE_INFO(DIRECTION_ID, false),         // direction
+    CONTROL_TYPE_INFO(TEXT_BOX_ID, true),           // textBox
+    CONTROL_TYPE_INFO(SELECTOR_ID, true),           // selector
+    CONTROL_TYPE_INFO(GRAPH_ID, false),             // graph
+    CONTROL_TYPE_INFO(TIME_GRAPH_ID, true),         // timeGraph
+    CONTROL_TYPE_INFO(MAP_ID, false),               // mapper
+    CONTROL_TYPE_INFO(COLOR_ID, false),             // colorPicker
+    CONTROL_TYPE_INFO(AV_ID, false),                // audioVisual
+    CONTROL_TYPE_INFO(DEVICE_NAME_ID, true),        // deviceName
+    CONTROL_TYPE_INFO(WIFI_SETUP_ID, true),         // wifiSetup
+    CONTROL_TYPE_INFO(TCP_SETUP_ID, true),          // tcpSetup
+    CONTROL_TYPE_INFO(DASHIO_SETUP_ID, true),       // dashioSetup
+    CONTROL_TYPE_INFO(MQTT_SETUP_ID, true),         // mqttSetup
+    CONTROL_TYPE_INFO("", false)                    // unknown
+};
+
+static_assert(sizeof(controlTypes) / sizeof(controlTypes[0]) == unknown + 1, "controlTypes must have an entry for every ControlType");
 
-String formatFloat(float value) {
-    if (value == INVALID_FLOAT_VALUE) {
-        return "nan";
-    } else if (abs(value) < SMALLEST_FLOAT_VALUE) {
-        return "0";
+ControlType getControlTypeFromID(const char *idStr, size_t idLength) {
+    if (idLength == 0) {
+        return unknown;
     }
-    
-    char buffer[16];
-#ifdef ARDUINO_ARCH_AVR
-    dtostrf(value, 5, 2, buffer);
-    return buffer;
-#else
-    if ((abs(value) < 1.0) || (abs(value) >= 100000)){
-        sprintf(buffer, "%5.2e", value);
-    } else {
-        sprintf(buffer, "%5.2f", value);
+    for (int i = 0; i < unknown; i++) {
+        const ControlTypeInfo& info = controlTypes[i];
+        if (info.received && (info.idLength == idLength) && (info.id[0] == idStr[0]) && (memcmp(info.id, idStr, idLength) == 0)) {
+            return (ControlType)i;
+        }
     }
-    return buffer;
-#endif
+    return unknown;
 }
 
-String formatInt(int value) {
-    if (value == INVALID_INT_VALUE) {
-        return "nan";
-    } else {
-        return String(value);
+// 32 bit FNV-1a hash of everything written to it
+class HashSink : public Print {
+public:
+    uint32_t hash = 2166136261UL;
+
+    size_t write(uint8_t chr) {
+        hash = (hash ^ chr) * 16777619UL;
+        return 1;
     }
+
+    size_t write(const uint8_t *buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            write(buffer[i]);
+        }
+        return size;
+    }
+};
+
+// MessageData field indexes
+#define DEVICE_ID_FIELD 0
+#define ID_FIELD 1
+#define PAYLOAD_FIELD 2
+#define PAYLOAD2_FIELD 3
+
+const char END_DELIM = '\n';
+const char DELIM = '\t';
+
+bool TextSpan::equals(const char *str) const {
+    return (strncmp(text, str, length) == 0) && (str[length] == '\0');
+}
+
+String TextSpan::toString() const {
+    return String(text);
 }
 
 MessageData::MessageData(ConnectionType connType) {
     deviceID.reserve(MAX_STRING_LEN);
     idStr.reserve(MAX_STRING_LEN);
     payloadStr.reserve(MAX_STRING_LEN);
+    buffer[0] = '\0';
     
     connectionType = connType;
 };
 
 void MessageData::processMessage(const String& message) {
-    if (message.length() > 0) {
-        if (messageReceived) {
-            Serial.println(F("Incoming message overflow. Can't process:"));
-            Serial.println(message);
-        } else {
-            for (unsigned int i = 0; i < message.length(); i++) {
-                char chr = message[i];
-                if (processChar(chr)) {
-                    messageReceived = true;
-                }
+    processMessage(message.c_str(), message.length());
+}
+
+void MessageData::processMessage(const char *message, size_t messageLength) {
+    for (size_t i = 0; i < messageLength; i++) {
+        if (parseChar(message[i])) {
+            if (messageWaiting) {
+                droppedMessages++;
+            } else {
+                setCurrentMessage(readControl, readFields);
+                messageWaiting = true;
             }
         }
     }
 }
 
+bool MessageData::nextMessage() {
+    if (messageWaiting) {
+        messageWaiting = false;
+        return true;
+    }
+    return false;
+}
+
+bool MessageData::messageReceived() {
+    return messageWaiting;
+}
+
+#if MESSAGE_QUEUE_DEPTH > 0
+static_assert((MESSAGE_QUEUE_DEPTH & (MESSAGE_QUEUE_DEPTH - 1)) == 0, "MESSAGE_QUEUE_DEPTH must be a power of 2");
+static_assert(MESSAGE_QUEUE_DEPTH <= 128, "MESSAGE_QUEUE_DEPTH must fit the uint8_t queue indexes");
+
+void QueuedMessageData::processMessage(const char *message, size_t messageLength) {
+    for (size_t i = 0; i < messageLength; i++) {
+        if (parseChar(message[i])) {
+            queueMessage();
+        }
+    }
+}
+
+// The fields are packed one after the other, each with a terminating null
+void QueuedMessageData::queueMessage() {
+    uint8_t tail = queueTail.load(std::memory_order_relaxed);
+    if ((uint8_t)(tail - queueHead.load(std::memory_order_acquire)) >= MESSAGE_QUEUE_DEPTH) {
+        droppedMessages++;
+        return;
+    }
+
+    QueuedMessage& message = queue[tail % MESSAGE_QUEUE_DEPTH];
+    message.control = readControl;
+    size_t pos = 0;
+    for (int i = 0; i < MESSAGE_FIELDS; i++) {
+        size_t fieldLength = 0;
+        if (pos < MESSAGE_BUFFER_LEN) {
+            fieldLength = min(readFields[i].length, (size_t)(MESSAGE_BUFFER_LEN - 1 - pos));
+            memcpy(&message.text[pos], readFields[i].text, fieldLength);
+            message.text[pos + fieldLength] = '\0';
+            pos += fieldLength + 1;
+        }
+        message.fieldLengths[i] = fieldLength;
+    }
+
+    queueTail.store(tail + 1, std::memory_order_release); // The message is complete before the consumer can see it
+}
+
+bool QueuedMessageData::nextMessage() {
+    uint8_t head = queueHead.load(std::memory_order_relaxed);
+    if (queueHeadInUse) { // The current message was the head, so can now be freed
+        head++;
+        queueHead.store(head, std::memory_order_release);
+        queueHeadInUse = false;
+    }
+    if (head == queueTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    QueuedMessage& message = queue[head % MESSAGE_QUEUE_DEPTH];
+    TextSpan fields[MESSAGE_FIELDS];
+    size_t pos = 0;
+    for (int i = 0; i < MESSAGE_FIELDS; i++) {
+        if (pos < MESSAGE_BUFFER_LEN) {
+            fields[i] = TextSpan(&message.text[pos], message.fieldLengths[i]);
+        }
+        pos += message.fieldLengths[i] + 1;
+    }
+    setCurrentMessage(message.control, fields);
+    queueHeadInUse = true;
+    return true;
+}
+
+bool QueuedMessageData::messageReceived() {
+    uint8_t queued = queueTail.load(std::memory_order_acquire) - queueHead.load(std::memory_order_relaxed);
+    return queued > (queueHeadInUse ? 1 : 0);
+}
+#endif
+
+void MessageData::setCurrentMessage(ControlType _control, const TextSpan fields[]) {
+    control = _control;
+    deviceIDSpan = fields[DEVICE_ID_FIELD];
+    idSpan = fields[ID_FIELD];
+    payloadSpan = fields[PAYLOAD_FIELD];
+    payloadSpan2 = fields[PAYLOAD2_FIELD];
+
+    if (stringFields) {
+        deviceID = deviceIDSpan.text;
+        idStr = idSpan.text;
+        payloadStr = payloadSpan.text;
+        payloadStr2 = payloadSpan2.text;
+    }
+}
+
 bool MessageData::processChar(char chr) {
+    if (parseChar(chr)) {
+        setCurrentMessage(readControl, readFields);
+        return true;
+    }
+    return false;
+}
+
+void MessageData::reset() {
+    segmentCount = -1;
+    readStart = 0;
+    readLength = 0;
+}
+
+// Terminates the segment being read in place and starts the next one straight after it
+TextSpan MessageData::endSegment() {
+    TextSpan segment(&buffer[readStart], readLength);
+    buffer[readStart + readLength] = '\0';
+    readStart += readLength;
+    if (readStart < MESSAGE_BUFFER_LEN - 1) {
+        readStart++;
+    }
+    readLength = 0;
+    return segment;
+}
+
+bool MessageData::parseChar(char chr) {
     bool messageEnd = false;
     if ((chr == DELIM) || (chr == END_DELIM)) {
-        if ((readStr.length() > 0) || (segmentCount == 1)) { // segmentCount == 1 allows for empty second field ??? maybe should be 2 for empty third field now that we've added deviceID at the front
+        if ((readLength > 0) || (segmentCount == 1)) { // segmentCount == 1 allows for empty second field ??? maybe should be 2 for empty third field now that we've added deviceID at the front
+            TextSpan segment = endSegment();
             switch (segmentCount) {
             case 0:
-                if (readStr == WHO_ID) {
-                    deviceID = "---";
-                    control = who;
+                if (segment.equals(WHO_ID)) {
+                    readFields[DEVICE_ID_FIELD] = TextSpan("---", 3);
+                    readControl = who;
                 } else {
-                    deviceID = readStr;
-                    control = unknown;
+                    readFields[DEVICE_ID_FIELD] = segment;
+                    readControl = unknown;
                 }
-                      
-                idStr = "";
-                payloadStr = "";
-                payloadStr2 = "";
+                readFields[ID_FIELD] = TextSpan();
+                readFields[PAYLOAD_FIELD] = TextSpan();
+                readFields[PAYLOAD2_FIELD] = TextSpan();
                 break;
             case 1:
-                if (readStr == WHO_ID) {
-                    control = who;
-                } else if (readStr == CONNECT_ID) {
-                    control = connect;
-                } else if (readStr == STATUS_ID) {
-                    control = status;
-                } else if (readStr == CONFIG_ID) {
-                    control = config;
-                } else if (readStr == BUTTON_ID) {
-                    control = button;
-                } else if (readStr == SLIDER_ID) {
-                    control = slider;
-                } else if (readStr == KNOB_ID) {
-                    control = knob;
-                } else if (readStr == TEXT_BOX_ID) {
-                    control = textBox;
-                } else if (readStr == TIME_GRAPH_ID) {
-                    control = timeGraph;
-                } else if (readStr == MENU_ID) {
-                    control = menu;
-                } else if (readStr == BUTTON_GROUP_ID) {
-                    control = buttonGroup;
-                } else if (readStr == EVENT_LOG_ID) {
-                    control = eventLog;
-                } else if (readStr == SELECTOR_ID) {
-                    control = selector;
-                } else if (readStr == DEVICE_NAME_ID) {
-                    control = deviceName;
-                } else if (readStr == WIFI_SETUP_ID) {
-                    control = wifiSetup;
-                } else if (readStr == TCP_SETUP_ID) {
-                    control = tcpSetup;
-                } else if (readStr == DASHIO_SETUP_ID) {
-                    control = dashioSetup;
-                } else if (readStr == MQTT_SETUP_ID) {
-                    control = mqttSetup;
-                } else {
-                    control = unknown;
-                    segmentCount == -1;
-                }
+                readControl = getControlTypeFromID(segment.text, segment.length);
                 break;
             case 2:
-                idStr = readStr;
+                readFields[ID_FIELD] = segment;
                 break;
             case 3:
-                payloadStr = readStr;
+                readFields[PAYLOAD_FIELD] = segment;
                 break;
             case 4:
-                payloadStr2 = readStr;
+                readFields[PAYLOAD2_FIELD] = segment;
                 break;
             default:
-                    segmentCount = 0;
+                segmentCount = 0;
             }
 
             if (segmentCount >= 0) {
                 segmentCount++;
                 if (chr == END_DELIM) { // End of message, so process message
-                  messageEnd = true;
+                    messageEnd = true;
                     segmentCount = -1; // Wait for next start of message
                 }
             }
         } else {
             segmentCount = 0; // Must have no data before DELIM or a DELIM + DELIM, so must be start of message
+            readStart = 0;
         }
-        readStr = "";
-    } else {
-        readStr += chr;
+        readLength = 0;
+    } else if (readStart + readLength < MESSAGE_BUFFER_LEN - 1) { // Leave room for the terminating null, so long fields are truncated
+        buffer[readStart + readLength] = chr;
+        readLength++;
     }
     return messageEnd;
 }
@@ -291,6 +444,8 @@ void DashioDevice::setup(const String& deviceIdentifier) {
     }
     deviceID.reserve(MAX_STRING_LEN);
     deviceID = deviceIdentifier;
+    configChanged = true;
+    configHashValid = false;
 }
 
 void DashioDevice::setup(const String& deviceIdentifier, const String& _deviceName) {
@@ -298,6 +453,8 @@ void DashioDevice::setup(const String& deviceIdentifier, const String& _deviceNa
 
     deviceID.reserve(MAX_STRING_LEN);
     deviceID = deviceIdentifier;
+    configChanged = true;
+    configHashValid = false;
 }
 
 void DashioDevice::setup(uint8_t m_address[6], const String& _deviceName) {
@@ -345,558 +502,1028 @@ void DashioDevice::setup(uint8_t m_address[6]) {
     macStr += buffer;
 
     deviceID = macStr.c_str();
+    configChanged = true;
+    configHashValid = false;
 }
 
-String DashioDevice::getOnlineMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += MQTT_ONLINE_MSSG;
+
+void DashioDevice::setConfigBuilder(void (*_configBuilder)(MessageWriter& writer)) {
+    configBuilder = _configBuilder;
+    configChanged = true;
+    configHashValid = false;
+}
+
+void DashioDevice::setConfigTable(const ConfigTableEntry *_configTable, size_t _configTableLength) {
+    configTable = _configTable;
+    configTableLength = _configTableLength;
+    configChanged = true;
+    configHashValid = false;
+}
+
+bool DashioDevice::hasConfigSnapshot() {
+    return (configBuilder != NULL) || (configTableLength > 0);
+}
+
+void DashioDevice::writeConfig(MessageWriter& writer) {
+    for (size_t i = 0; i < configTableLength; i++) {
+        ConfigTableEntry entry(unknown, NULL);
+        memcpy_P(&entry, &configTable[i], sizeof(entry));
+        writeConfigTableEntry(writer, entry);
+    }
+    if (configBuilder != NULL) {
+        configBuilder(writer);
+    }
+}
+
+// The descriptor may be in PROGMEM, so it is copied to the stack before it is written
+template <typename Desc> bool DashioDevice::writeConfigDesc(MessageWriter& writer, const void *desc) {
+    alignas(Desc) char descBuffer[sizeof(Desc)];
+    memcpy_P(descBuffer, desc, sizeof(Desc));
+    return writeConfigMessage(writer, *reinterpret_cast<const Desc *>(descBuffer));
+}
+
+bool DashioDevice::writeConfigTableEntry(MessageWriter& writer, const ConfigTableEntry& entry) {
+    switch (entry.controlType) {
+        case device:
+            return writeConfigDesc<DeviceDesc>(writer, entry.desc);
+        case deviceView:
+            return writeConfigDesc<DeviceViewDesc>(writer, entry.desc);
+        case alarmNotify:
+            return writeConfigDesc<AlarmDesc>(writer, entry.desc);
+        case label:
+            return writeConfigDesc<LabelDesc>(writer, entry.desc);
+        case button:
+            return writeConfigDesc<ButtonDesc>(writer, entry.desc);
+        case menu:
+            return writeConfigDesc<MenuDesc>(writer, entry.desc);
+        case buttonGroup:
+            return writeConfigDesc<ButtonGroupDesc>(writer, entry.desc);
+        case eventLog:
+            return writeConfigDesc<EventLogDesc>(writer, entry.desc);
+        case knob:
+            return writeConfigDesc<KnobDesc>(writer, entry.desc);
+        case dial:
+            return writeConfigDesc<DialDesc>(writer, entry.desc);
+        case direction:
+            return writeConfigDesc<DirectionDesc>(writer, entry.desc);
+        case textBox:
+            return writeConfigDesc<TextBoxDesc>(writer, entry.desc);
+        case selector:
+            return writeConfigDesc<SelectorDesc>(writer, entry.desc);
+        case slider:
+            return writeConfigDesc<SliderDesc>(writer, entry.desc);
+        case graph:
+            return writeConfigDesc<GraphDesc>(writer, entry.desc);
+        case timeGraph:
+            return writeConfigDesc<TimeGraphDesc>(writer, entry.desc);
+        case mapper:
+            return writeConfigDesc<MapDesc>(writer, entry.desc);
+        case colorPicker:
+            return writeConfigDesc<ColorDesc>(writer, entry.desc);
+        case audioVisual:
+            return writeConfigDesc<AudioVisualDesc>(writer, entry.desc);
+        default:
+            return false;
+    }
+}
+
+
+void DashioDevice::setConfigChanged() {
+    configChanged = true;
+    configHashValid = false;
+}
+
+void DashioDevice::setOmitConfigDefaults(bool omit) {
+    omitConfigDefaults = omit;
+    setConfigChanged();
+}
+
+// The snapshot is written for broadcast, so it is the same for every dashboard and only changes with the config
+const String& DashioDevice::getConfigSnapshot() {
+    if (!hasConfigSnapshot()) {
+        configSnapshot = "";
+    } else if (configChanged) {
+        writingBroadcastConfig = true;
+        MessageWriter sizer;
+        writeConfig(sizer);
+        configSnapshot.reserve(sizer.length());
+        MessageWriter writer(configSnapshot);
+        writeConfig(writer);
+        writingBroadcastConfig = false;
+        configChanged = false;
+    }
+    return configSnapshot;
+}
+
+size_t DashioDevice::writeConfigPage(MessageWriter& writer, size_t pageStart, size_t maxPageLength, const char *clientDashboardID) {
+    const String& snapshot = getConfigSnapshot();
+    size_t snapshotLength = snapshot.length();
+    const char *snapshotStr = snapshot.c_str();
+    if ((pageStart >= snapshotLength) || ((pageStart > 0) && (snapshotStr[pageStart - 1] != END_DELIM))) { // Finished, or the config changed while it was being sent
+        return 0;
+    }
+
+    // Config messages start "\t<deviceID>\tCFG\tBRDCST\t" in the snapshot. The dashboard's ID goes in place of BRDCST
+    static const char broadcastConfig[] = CONFIG_ID "\t" BROADCAST_ID "\t";
+    size_t broadcastConfigPos = deviceID.length() + 2;
+    size_t broadcastIDPos = broadcastConfigPos + strlen(CONFIG_ID) + 1;
+    size_t broadcastIDLength = strlen(BROADCAST_ID);
+    size_t clientDashboardIDLength = strlen(clientDashboardID);
+
+    size_t pageEnd = pageStart;
+    size_t pageLength = 0;
+    while (pageEnd < snapshotLength) {
+        const char *message = snapshotStr + pageEnd;
+        const char *messageEnd = strchr(message, END_DELIM);
+        size_t messageLength = (messageEnd == NULL) ? snapshotLength - pageEnd : messageEnd - message + 1;
+        bool isBroadcast = (messageLength > broadcastConfigPos + sizeof(broadcastConfig) - 1) &&
+                           (strncmp(message + broadcastConfigPos, broadcastConfig, sizeof(broadcastConfig) - 1) == 0);
+        size_t clientMessageLength = isBroadcast ? messageLength - broadcastIDLength + clientDashboardIDLength : messageLength;
+        if ((pageEnd > pageStart) && (pageLength + clientMessageLength > maxPageLength)) {
+            break;
+        }
+
+        if (isBroadcast) {
+            writer.add(message, broadcastIDPos);
+            writer.add(clientDashboardID, clientDashboardIDLength);
+            writer.add(message + broadcastIDPos + broadcastIDLength, messageLength - broadcastIDPos - broadcastIDLength);
+        } else {
+            writer.add(message, messageLength);
+        }
+        pageLength += clientMessageLength;
+        pageEnd += messageLength;
+    }
+    return pageEnd - pageStart;
+}
+
+uint32_t DashioDevice::getConfigHash() {
+    if (!configHashValid && hasConfigSnapshot()) {
+        // Hashed as written for broadcast, the same as the snapshot
+        writingBroadcastConfig = true;
+        HashSink hashSink;
+        char buffer[32];
+        MessageWriter writer(buffer, sizeof(buffer), hashSink);
+        writeConfig(writer);
+        writer.flush();
+        writingBroadcastConfig = false;
+
+        configHash = hashSink.hash;
+        configHashValid = true;
+    }
+    return configHash;
+}
+
+const char * DashioDevice::getConfigHashStr(char *hashStr) {
+    uint32_t hash = getConfigHash();
+    for (int i = CONFIG_HASH_LEN - 1; i >= 0; i--) {
+        hashStr[i] = "0123456789abcdef"[hash & 0x0F];
+        hash >>= 4;
+    }
+    hashStr[CONFIG_HASH_LEN] = '\0';
+    return hashStr;
+}
+
+bool DashioDevice::isConfigUnchanged(const String& clientConfigHash) {
+    if (!hasConfigSnapshot() || (clientConfigHash.length() != CONFIG_HASH_LEN)) {
+        return false;
+    }
+    char hashStr[CONFIG_HASH_LEN + 1];
+    return clientConfigHash == getConfigHashStr(hashStr);
+}
+
+// The String returning methods write their message once into a String reserved for its fixed parts and text.
+// Variable length messages (arrays, tracks, event logs and config) are measured first instead.
+template <typename WriteMessage>
+String DashioDevice::getShortMessage(size_t textLength, WriteMessage writeMessage) {
+    String message((char *)0);
+    message.reserve(deviceID.length() + SHORT_MESSAGE_LEN + textLength);
+    MessageWriter writer(message);
+    writeMessage(writer);
     return message;
 }
 
-String DashioDevice::getOfflineMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += MQTT_OFFLINE_MSSG;
+template <typename WriteMessage>
+String DashioDevice::getMeasuredMessage(WriteMessage writeMessage) {
+    MessageWriter sizer;
+    writeMessage(sizer);
+    String message((char *)0);
+    message.reserve(sizer.length());
+    MessageWriter writer(message);
+    writeMessage(writer);
     return message;
 }
 
+String DashioDevice::getConfigReply(const String& clientDashboardID) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigPage(writer, 0, SIZE_MAX, clientDashboardID.c_str());
+    });
+}
+
+String DashioDevice::getConfigUnchangedMessage(const String& clientDashboardID) {
+    return getShortMessage(clientDashboardID.length(), [&](MessageWriter& writer) {
+        writeConfigUnchangedMessage(writer, clientDashboardID.c_str());
+    });
+}
+
+bool DashioDevice::handleConfigRequest(const MessageData& data, String& reply, bool pagedReply) {
+    if (data.control != config) {
+        return false;
+    }
+    if (!hasConfigSnapshot()) {
+        dashboardID = data.idStr;
+        return false;
+    }
+
+    if (isConfigUnchanged(data.payloadStr)) {
+        reply = getConfigUnchangedMessage(data.idStr);
+    } else if (pagedReply) {
+        reply = "";
+    } else {
+        reply = getConfigReply(data.idStr);
+    }
+    return true;
+}
+
+String DashioDevice::getOnlineMessage() {
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeOnlineMessage(writer);
+    });
+}
+
+String DashioDevice::getOfflineMessage() {
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeOfflineMessage(writer);
+    });
+}
+
 String DashioDevice::getWhoMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += WHO_ID;
-    message += String(DELIM);
-    message += type;
-    message += String(DELIM);
-    message += name;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(type.length() + name.length(), [&](MessageWriter& writer) {
+        writeWhoMessage(writer);
+    });
 }
 
 String DashioDevice::getConnectMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += CONNECT_ID;
-    message += String(END_DELIM);
-    return  message;
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeConnectMessage(writer);
+    });
 }
 
 String DashioDevice::getDeviceNameMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += DEVICE_NAME_ID;
-    message += String(DELIM);
-    message += name;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(name.length(), [&](MessageWriter& writer) {
+        writeDeviceNameMessage(writer);
+    });
 }
 
 String DashioDevice::getWifiUpdateAckMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += WIFI_SETUP_ID;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeWifiUpdateAckMessage(writer);
+    });
 }
 
 String DashioDevice::getTCPUpdateAckMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += TCP_SETUP_ID;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeTCPUpdateAckMessage(writer);
+    });
 }
 
 String DashioDevice::getDashioUpdateAckMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += DASHIO_SETUP_ID;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeDashioUpdateAckMessage(writer);
+    });
 }
 
 String DashioDevice::getMQTTUpdateAckMessage() {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += MQTT_SETUP_ID;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(0, [&](MessageWriter& writer) {
+        writeMQTTUpdateAckMessage(writer);
+    });
 }
 
 String DashioDevice::getAlarmMessage(const String& controlID, const String& title, const String& description) {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += controlID;
-    message += String(DELIM);
-    message += title;
-    message += String(DELIM);
-    message += description;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + title.length() + description.length(), [&](MessageWriter& writer) {
+        writeAlarmMessage(writer, controlID.c_str(), title.c_str(), description.c_str());
+    });
 }
 
 String DashioDevice::getAlarmMessage(Notification alarm) {
     return getAlarmMessage(alarm.identifier, alarm.title, alarm.description);
 }
 
-String DashioDevice::getControlBaseMessage(const String& controlType, const String& controlID) {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += controlType;
-    message += String(DELIM);
-    message += controlID;
-    message += String(DELIM);
-    return message;
-}
-
 String DashioDevice::getButtonMessage(const String& controlID, bool on, const String& iconName, const String& text) {
-    String message = getControlBaseMessage(BUTTON_ID, controlID);
-    if (on) {
-        message += BUTTON_ON;
-    } else {
-        message += BUTTON_OFF;
-    }
-    if (text != "") {
-        message += String(DELIM);
-        message += iconName;
-        message += String(DELIM);
-        message += text;
-    } else {
-        if (iconName != "") {
-            message += String(DELIM);
-            message += iconName;
-        }
-    }
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + iconName.length() + text.length(), [&](MessageWriter& writer) {
+        writeButtonMessage(writer, controlID.c_str(), on, iconName.c_str(), text.c_str());
+    });
 }
 
 String DashioDevice::getTextBoxMessage(const String& controlID, const String& text) {
-    String message = getControlBaseMessage(TEXT_BOX_ID, controlID);
-    message += text;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + text.length(), [&](MessageWriter& writer) {
+        writeTextBoxMessage(writer, controlID.c_str(), text.c_str());
+    });
 }
 
 String DashioDevice::getSelectorMessage(const String& controlID, int index) {
-    String message = getControlBaseMessage(SELECTOR_ID, controlID);
-    message += String(index);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeSelectorMessage(writer, controlID.c_str(), index);
+    });
 }
 
 String DashioDevice::getSelectorMessage(const String& controlID, int index, String* selectionItems, int numItems) {
-    String message = getControlBaseMessage(SELECTOR_ID, controlID);
-    message += String(index);
-    for (int i = 0; i < numItems; i++) {
-        message += String(DELIM);
-        message += selectionItems[i];
-    }
-    message += String(END_DELIM);
-    return message;
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeSelectorMessage(writer, controlID.c_str(), index, selectionItems, numItems);
+    });
 }
 
 String DashioDevice::getSliderMessage(const String& controlID, int value) {
-    String message = getControlBaseMessage(SLIDER_ID, controlID);
-    message += formatInt(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeSliderMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getSliderMessage(const String& controlID, float value) {
-    String message = getControlBaseMessage(SLIDER_ID, controlID);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeSliderMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getSingleBarMessage(const String& controlID, int value) {
-    String message = getControlBaseMessage(BAR_ID, controlID);
-    message += formatInt(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeSingleBarMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getSingleBarMessage(const String& controlID, float value) {
-    String message = getControlBaseMessage(BAR_ID, controlID);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeSingleBarMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getDoubleBarMessage(const String& controlID, int value1, int value2) {
-    int barValues[2];
-    barValues[0] = value1;
-    barValues[1] = value2;
-    return getIntArray(BAR_ID, controlID, barValues, 2);
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDoubleBarMessage(writer, controlID.c_str(), value1, value2);
+    });
 }
 
 String DashioDevice::getDoubleBarMessage(const String& controlID, float value1, float value2) {
-    float barValues[2];
-    barValues[0] = value1;
-    barValues[1] = value2;
-    return getFloatArray(BAR_ID, controlID, barValues, 2);
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDoubleBarMessage(writer, controlID.c_str(), value1, value2);
+    });
 }
 
 String DashioDevice::getKnobMessage(const String& controlID, int value) {
-    String message = getControlBaseMessage(KNOB_ID, controlID);
-    message += formatInt(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeKnobMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getKnobMessage(const String& controlID, float value) {
-    String message = getControlBaseMessage(KNOB_ID, controlID);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeKnobMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getKnobDialMessage(const String& controlID, int value) {
-    String message = getControlBaseMessage(KNOB_DIAL_ID, controlID);
-    message += formatInt(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeKnobDialMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getKnobDialMessage(const String& controlID, float value) {
-    String message = getControlBaseMessage(KNOB_DIAL_ID, controlID);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeKnobDialMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getDialMessage(const String& controlID, int value) {
-    String message = getControlBaseMessage(DIAL_ID, controlID);
-    message += formatInt(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDialMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getDialMessage(const String& controlID, float value) {
-    String message = getControlBaseMessage(DIAL_ID, controlID);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDialMessage(writer, controlID.c_str(), value);
+    });
 }
 
 String DashioDevice::getDirectionMessage(const String& controlID, int direction, float speed) {
-    String message = getControlBaseMessage(DIRECTION_ID, controlID);
-    message += formatInt(direction);
-    if (speed >= 0) {
-        message += String(DELIM);
-        message += formatFloat(speed);
-    }
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDirectionMessage(writer, controlID.c_str(), direction, speed);
+    });
 }
 
 String DashioDevice::getDirectionMessage(const String& controlID, float direction, float speed) {
-    String message = getControlBaseMessage(DIRECTION_ID, controlID);
-    message += formatFloat(direction);
-    if (speed >= 0) {
-        message += String(DELIM);
-        message += formatFloat(speed);
-    }
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length(), [&](MessageWriter& writer) {
+        writeDirectionMessage(writer, controlID.c_str(), direction, speed);
+    });
 }
 
 String DashioDevice::getMapWaypointMessage(const String& controlID, const String& trackID, const String& latitude, const String& longitude) {
-    String message = getControlBaseMessage(MAP_ID, controlID);
-    message += trackID;
-    message += String(DELIM);
-    message += latitude;
-    message += ",";
-    message += longitude;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + trackID.length() + latitude.length() + longitude.length(), [&](MessageWriter& writer) {
+        writeMapWaypointMessage(writer, controlID.c_str(), trackID.c_str(), latitude.c_str(), longitude.c_str());
+    });
 }
 
 String DashioDevice::getMapTrackMessage(const String& controlID, const String& trackID, const String& text, const String& colour, Waypoint waypoints[], int numWaypoints) {
-    String message = getControlBaseMessage(MAP_ID, controlID);
-    message += dashboardID;
-    message += String(DELIM);
-    message += trackID;
-    message += String(DELIM);
-    message += text;
-    message += String(DELIM);
-    message += colour;
-    
-    for (int i = 0; i < numWaypoints; i++) {
-        message += String(DELIM);
-        message += getWaypointJSON(waypoints[i]);
-    }
-    
-    message += String(END_DELIM);
-    return message;
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeMapTrackMessage(writer, controlID.c_str(), trackID.c_str(), text.c_str(), colour.c_str(), waypoints, numWaypoints);
+    });
+}
+
+String DashioDevice::getMapWaypointMessage(const String& controlID, const String& trackID, const TrackPoint& waypoint) {
+    return getShortMessage(controlID.length() + trackID.length(), [&](MessageWriter& writer) {
+        writeMapWaypointMessage(writer, controlID.c_str(), trackID.c_str(), waypoint);
+    });
+}
+
+String DashioDevice::getMapTrackMessage(const String& controlID, const String& trackID, const String& text, const String& colour, const TrackPoint waypoints[], int numWaypoints) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeMapTrackMessage(writer, controlID.c_str(), trackID.c_str(), text.c_str(), colour.c_str(), waypoints, numWaypoints);
+    });
 }
 
 String DashioDevice::getColorMessage(const String& controlID, const String& color) {
-    String message = getControlBaseMessage(COLOR_ID, controlID);
-    message += color;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + color.length(), [&](MessageWriter& writer) {
+        writeColorMessage(writer, controlID.c_str(), color.c_str());
+    });
 }
 
 String DashioDevice::getAudioVisualMessage(const String& controlID, const String& url) {
-    String message = getControlBaseMessage(AV_ID, controlID);
-    message += url;
-    message += String(END_DELIM);
-    return message;
+    return getShortMessage(controlID.length() + url.length(), [&](MessageWriter& writer) {
+        writeAudioVisualMessage(writer, controlID.c_str(), url.c_str());
+    });
 }
 
 String DashioDevice::getEventLogMessage(const String& controlID, const String& timeStr, const String& color, String text[], int numTextRows) {
-    String message = getControlBaseMessage(EVENT_LOG_ID, controlID);
-    message += timeStr;
-    message += String(DELIM);
-    message += color;
-    for (int i = 0; i < numTextRows; i++) {
-        message += String(DELIM);
-        message += text[i];
-    }
-    message += String(END_DELIM);
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeEventLogMessage(writer, controlID.c_str(), timeStr.c_str(), color.c_str(), text, numTextRows);
+    });
+}
+
+String DashioDevice::getEventLogMessage(const String& controlID, Event events[], int numEvents) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeEventLogMessage(writer, controlID.c_str(), events, numEvents);
+    });
+}
+
+String DashioDevice::getBasicConfigData(ControlType controlType, const String& controlID, const String& controlTitle) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeBasicConfigData(writer, controlType, controlID.c_str(), controlTitle.c_str());
+    });
+}
+
+String DashioDevice::getBasicConfigMessage(ControlType controlType, const String& controlID, const String& controlTitle) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeBasicConfigMessage(writer, controlType, controlID.c_str(), controlTitle.c_str());
+    });
+}
+
+String DashioDevice::getBasicConfigMessage(const String& configData) {
+    String message((char *)0);
+    MessageWriter writer(message);
+    writeDeviceMessage(writer, CONFIG_ID);
+    writer.add(DELIM);
+    writer.add(dashboardID);
+    writer.add(DELIM);
+    writer.add(BASIC_CONFIG_ID);
+    writer.add(configData);
+    writer.add(END_DELIM);
     return message;
 }
 
-String DashioDevice::getEventLogMessage(const String& controlID, Event events[], int numEvents) {
-    String message = getControlBaseMessage(EVENT_LOG_ID, controlID);
-    message += dashboardID;
-    message += String(DELIM);
+String DashioDevice::getFullConfigMessage(ControlType controlType, const String& configData) {
+    String message((char *)0);
+    MessageWriter writer(message);
+    writeFullConfigHeader(writer, controlType);
+    writer.add(configData);
+    writer.add(END_DELIM);
+    return message;
+}
+
+String DashioDevice::getGraphLineInts(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, int lineData[], int dataLength) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeGraphLineInts(writer, controlID.c_str(), graphLineID.c_str(), lineName.c_str(), lineType, color.c_str(), lineData, dataLength);
+    });
+}
+
+String DashioDevice::getGraphLineFloats(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, float lineData[], int dataLength) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeGraphLineFloats(writer, controlID.c_str(), graphLineID.c_str(), lineName.c_str(), lineType, color.c_str(), lineData, dataLength);
+    });
+}
+
+String DashioDevice::getTimeGraphLine(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color) {
+    return getShortMessage(controlID.length() + graphLineID.length() + lineName.length() + color.length(), [&](MessageWriter& writer) {
+        writeTimeGraphLine(writer, controlID.c_str(), graphLineID.c_str(), lineName.c_str(), lineType, color.c_str());
+    });
+}
+
+String DashioDevice::getTimeGraphLineFloats(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, String times[], float lineData[], int dataLength, bool breakLine) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeTimeGraphLineFloats(writer, controlID.c_str(), graphLineID.c_str(), lineName.c_str(), lineType, color.c_str(), times, lineData, dataLength, breakLine);
+    });
+}
+
+String DashioDevice::getTimeGraphPoint(const String& controlID, const String& graphLineID, float value) {
+    return getShortMessage(controlID.length() + graphLineID.length(), [&](MessageWriter& writer) {
+        writeTimeGraphPoint(writer, controlID.c_str(), graphLineID.c_str(), value);
+    });
+}
+
+String DashioDevice::getTimeGraphPoint(const String& controlID, const String& graphLineID, String time, float value) {
+    return getShortMessage(controlID.length() + graphLineID.length() + time.length(), [&](MessageWriter& writer) {
+        writeTimeGraphPoint(writer, controlID.c_str(), graphLineID.c_str(), time.c_str(), value);
+    });
+}
+
+String DashioDevice::getTimeGraphLineBools(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, String times[], bool lineData[], int dataLength) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeTimeGraphLineBools(writer, controlID.c_str(), graphLineID.c_str(), lineName.c_str(), lineType, color.c_str(), times, lineData, dataLength);
+    });
+}
+
+// Writer messages
+bool DashioDevice::writeOnlineMessage(MessageWriter& writer) {
+    writeDeviceHeader(writer);
+    writer.add(MQTT_ONLINE_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeOfflineMessage(MessageWriter& writer) {
+    writeDeviceHeader(writer);
+    writer.add(MQTT_OFFLINE_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeWhoMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, WHO_ID);
+    writer.add(DELIM);
+    writer.add(type);
+    writer.add(DELIM);
+    writer.add(name);
+    writeConfigHash(writer);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConnectMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, CONNECT_ID);
+    writeConfigHash(writer);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigUnchangedMessage(MessageWriter& writer, const char *clientDashboardID) {
+    writeDeviceMessage(writer, CONFIG_ID);
+    writer.add(DELIM);
+    writer.add(clientDashboardID);
+    writer.add(DELIM);
+    writer.add(CONFIG_UNCHANGED_ID);
+    writeConfigHash(writer);
+    return endMessage(writer);
+}
+
+// Only sent when there is a config snapshot, so messages are unchanged for devices that don't use it
+void DashioDevice::writeConfigHash(MessageWriter& writer) {
+    if (hasConfigSnapshot()) {
+        char hashStr[CONFIG_HASH_LEN + 1];
+        writer.add(DELIM);
+        writer.add(getConfigHashStr(hashStr));
+    }
+}
+
+bool DashioDevice::writeDeviceNameMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, DEVICE_NAME_ID);
+    writer.add(DELIM);
+    writer.add(name);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeWifiUpdateAckMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, WIFI_SETUP_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTCPUpdateAckMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, TCP_SETUP_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDashioUpdateAckMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, DASHIO_SETUP_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeMQTTUpdateAckMessage(MessageWriter& writer) {
+    writeDeviceMessage(writer, MQTT_SETUP_ID);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeAlarmMessage(MessageWriter& writer, const char *controlID, const char *title, const char *description) {
+    writeDeviceMessage(writer, controlID);
+    writer.add(DELIM);
+    writer.add(title);
+    writer.add(DELIM);
+    writer.add(description);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeButtonMessage(MessageWriter& writer, const char *controlID, bool on, const char *iconName, const char *text) {
+    writeControlBaseMessage(writer, BUTTON_ID, controlID);
+    if (on) {
+        writer.add(BUTTON_ON);
+    } else {
+        writer.add(BUTTON_OFF);
+    }
+    if (text[0] != '\0') {
+        writer.add(DELIM);
+        writer.add(iconName);
+        writer.add(DELIM);
+        writer.add(text);
+    } else {
+        if (iconName[0] != '\0') {
+            writer.add(DELIM);
+            writer.add(iconName);
+        }
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTextBoxMessage(MessageWriter& writer, const char *controlID, const char *text) {
+    writeControlBaseMessage(writer, TEXT_BOX_ID, controlID);
+    writer.add(text);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSelectorMessage(MessageWriter& writer, const char *controlID, int index) {
+    writeControlBaseMessage(writer, SELECTOR_ID, controlID);
+    writer.addInt(index);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSelectorMessage(MessageWriter& writer, const char *controlID, int index, const String selectionItems[], int numItems) {
+    writeControlBaseMessage(writer, SELECTOR_ID, controlID);
+    writer.addInt(index);
+    for (int i = 0; i < numItems; i++) {
+        writer.add(DELIM);
+        writer.add(selectionItems[i]);
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSliderMessage(MessageWriter& writer, const char *controlID, int value) {
+    writeControlBaseMessage(writer, SLIDER_ID, controlID);
+    writer.addInt(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSliderMessage(MessageWriter& writer, const char *controlID, float value) {
+    writeControlBaseMessage(writer, SLIDER_ID, controlID);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSingleBarMessage(MessageWriter& writer, const char *controlID, int value) {
+    writeControlBaseMessage(writer, BAR_ID, controlID);
+    writer.addInt(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeSingleBarMessage(MessageWriter& writer, const char *controlID, float value) {
+    writeControlBaseMessage(writer, BAR_ID, controlID);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDoubleBarMessage(MessageWriter& writer, const char *controlID, int value1, int value2) {
+    int barValues[2];
+    barValues[0] = value1;
+    barValues[1] = value2;
+    return writeIntArray(writer, BAR_ID, controlID, barValues, 2);
+}
+
+bool DashioDevice::writeDoubleBarMessage(MessageWriter& writer, const char *controlID, float value1, float value2) {
+    float barValues[2];
+    barValues[0] = value1;
+    barValues[1] = value2;
+    return writeFloatArray(writer, BAR_ID, controlID, barValues, 2);
+}
+
+bool DashioDevice::writeKnobMessage(MessageWriter& writer, const char *controlID, int value) {
+    writeControlBaseMessage(writer, KNOB_ID, controlID);
+    writer.addInt(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeKnobMessage(MessageWriter& writer, const char *controlID, float value) {
+    writeControlBaseMessage(writer, KNOB_ID, controlID);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeKnobDialMessage(MessageWriter& writer, const char *controlID, int value) {
+    writeControlBaseMessage(writer, KNOB_DIAL_ID, controlID);
+    writer.addInt(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeKnobDialMessage(MessageWriter& writer, const char *controlID, float value) {
+    writeControlBaseMessage(writer, KNOB_DIAL_ID, controlID);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDialMessage(MessageWriter& writer, const char *controlID, int value) {
+    writeControlBaseMessage(writer, DIAL_ID, controlID);
+    writer.addInt(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDialMessage(MessageWriter& writer, const char *controlID, float value) {
+    writeControlBaseMessage(writer, DIAL_ID, controlID);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDirectionMessage(MessageWriter& writer, const char *controlID, int direction, float speed) {
+    writeControlBaseMessage(writer, DIRECTION_ID, controlID);
+    writer.addInt(direction);
+    if (speed >= 0) {
+        writer.add(DELIM);
+        writer.addFloat(speed);
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeDirectionMessage(MessageWriter& writer, const char *controlID, float direction, float speed) {
+    writeControlBaseMessage(writer, DIRECTION_ID, controlID);
+    writer.addFloat(direction);
+    if (speed >= 0) {
+        writer.add(DELIM);
+        writer.addFloat(speed);
+    }
+    return endMessage(writer);
+}
+
+void DashioDevice::writeMapTrackHeader(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour) {
+    writeControlBaseMessage(writer, MAP_ID, controlID);
+    writer.add(dashboardID);
+    writer.add(DELIM);
+    writer.add(trackID);
+    writer.add(DELIM);
+    writer.add(text);
+    writer.add(DELIM);
+    writer.add(colour);
+}
+
+bool DashioDevice::writeMapWaypointMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *latitude, const char *longitude) {
+    writeControlBaseMessage(writer, MAP_ID, controlID);
+    writer.add(trackID);
+    writer.add(DELIM);
+    writer.add(latitude);
+    writer.add(',');
+    writer.add(longitude);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, const Waypoint waypoints[], int numWaypoints) {
+    writeMapTrackHeader(writer, controlID, trackID, text, colour);
+
+    for (int i = 0; i < numWaypoints; i++) {
+        writer.add(DELIM);
+        writeWaypointJSON(writer, waypoints[i]);
+    }
+
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeMapWaypointMessage(MessageWriter& writer, const char *controlID, const char *trackID, const TrackPoint& waypoint) {
+    char numberBuffer[FORMAT_BUFFER_SIZE];
+    writeControlBaseMessage(writer, MAP_ID, controlID);
+    writer.add(trackID);
+    writer.add(DELIM);
+    formatScaledInt(numberBuffer, waypoint.latitude, TRACK_DEGREES_DECIMALS);
+    writer.add(numberBuffer);
+    writer.add(',');
+    formatScaledInt(numberBuffer, waypoint.longitude, TRACK_DEGREES_DECIMALS);
+    writer.add(numberBuffer);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, const TrackPoint waypoints[], int numWaypoints) {
+    writeMapTrackHeader(writer, controlID, trackID, text, colour);
 
-    for (int i = 0; i < numEvents; i++) {
-        message += getEventJSON(events[i]);
-        if (i < numEvents - 1) { // because getControlBaseMessage ends in a DELIM
-            message += String(DELIM);
-        }
+    for (int i = 0; i < numWaypoints; i++) {
+        writer.add(DELIM);
+        writeTrackPointJSON(writer, waypoints[i]);
     }
-    message += String(END_DELIM);
-    return message;
-}
 
-String DashioDevice::getBasicConfigData(ControlType controlType, const String& controlID, const String& controlTitle) {
-    String message = String(DELIM);
-    message += getControlTypeStr(controlType);
-    message += String(DELIM);
-    message += controlID;
-    message += String(DELIM);
-    message += controlTitle;
-    return message;
+    return endMessage(writer);
 }
 
-String DashioDevice::getBasicConfigMessage(ControlType controlType, const String& controlID, const String& controlTitle) {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += CONFIG_ID;
-    message += String(DELIM);
-    message += BASIC_CONFIG_ID;
-    message += getBasicConfigData(controlType, controlID, controlTitle);
-    message += String(END_DELIM);
-    return message;
+bool DashioDevice::writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, bool (*getWaypoint)(int index, TrackPoint& waypoint)) {
+    writeMapTrackHeader(writer, controlID, trackID, text, colour);
+
+    TrackPoint waypoint;
+    for (int i = 0; getWaypoint(i, waypoint); i++) {
+        writer.add(DELIM);
+        writeTrackPointJSON(writer, waypoint);
+        waypoint = TrackPoint();
+    }
+
+    return endMessage(writer);
 }
 
-String DashioDevice::getBasicConfigMessage(const String& configData) {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += CONFIG_ID;
-    message += String(DELIM);
-    message += dashboardID;
-    message += String(DELIM);
-    message += BASIC_CONFIG_ID;
-    message += configData;
-    message += String(END_DELIM);
-    return  message;
+bool DashioDevice::writeColorMessage(MessageWriter& writer, const char *controlID, const char *color) {
+    writeControlBaseMessage(writer, COLOR_ID, controlID);
+    writer.add(color);
+    return endMessage(writer);
 }
 
-String DashioDevice::getFullConfigMessage(ControlType controlType, const String& configData) {
-    String message = String(DELIM);
-    message += deviceID;
-    message += String(DELIM);
-    message += CONFIG_ID;
-    message += String(DELIM);
-    message += dashboardID;
-    message += String(DELIM);
-    message += getControlTypeStr(controlType);
-    message += String(DELIM);
-    message += configData;
-    message += String(END_DELIM);
-    return message;
+bool DashioDevice::writeAudioVisualMessage(MessageWriter& writer, const char *controlID, const char *url) {
+    writeControlBaseMessage(writer, AV_ID, controlID);
+    writer.add(url);
+    return endMessage(writer);
 }
 
-String DashioDevice::getGraphLineInts(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, int lineData[], int dataLength) {
-    String message = getControlBaseMessage(GRAPH_ID, controlID);
-    message += graphLineID;
-    message += String(DELIM);
-    message += lineName;
-    message += String(DELIM);
-    message += getLineTypeStr(lineType);
-    message += String(DELIM);
-    message += color;
-    for (int i = 0; i < dataLength; i++) {
-        message += String(DELIM);
-        message += formatInt(lineData[i]);
+bool DashioDevice::writeEventLogMessage(MessageWriter& writer, const char *controlID, const char *timeStr, const char *color, const String text[], int numTextRows) {
+    writeControlBaseMessage(writer, EVENT_LOG_ID, controlID);
+    writer.add(timeStr);
+    writer.add(DELIM);
+    writer.add(color);
+    for (int i = 0; i < numTextRows; i++) {
+        writer.add(DELIM);
+        writer.add(text[i]);
     }
-    message += String(END_DELIM);
-    return message;
+    return endMessage(writer);
 }
 
-String DashioDevice::getGraphLineFloats(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, float lineData[], int dataLength) {
-    String message = getControlBaseMessage(GRAPH_ID, controlID);
-    message += graphLineID;
-    message += String(DELIM);
-    message += lineName;
-    message += String(DELIM);
-    message += getLineTypeStr(lineType);
-    message += String(DELIM);
-    message += color;
-    for (int i = 0; i < dataLength; i++) {
-        message += String(DELIM);
-        message += formatFloat(lineData[i]);
+bool DashioDevice::writeEventLogMessage(MessageWriter& writer, const char *controlID, const Event events[], int numEvents) {
+    writeControlBaseMessage(writer, EVENT_LOG_ID, controlID);
+    writer.add(dashboardID);
+    writer.add(DELIM);
+
+    for (int i = 0; i < numEvents; i++) {
+        writeEventJSON(writer, events[i]);
+        if (i < numEvents - 1) { // because writeControlBaseMessage ends in a DELIM
+            writer.add(DELIM);
+        }
     }
-    message += String(END_DELIM);
-    return message;
+    return endMessage(writer);
 }
 
-String DashioDevice::getTimeGraphLine(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color) {
-    String message = getControlBaseMessage(TIME_GRAPH_ID, controlID);
-    message += String("BRDCST");
-    message += String(DELIM);
-    message += graphLineID;
-    message += String(DELIM);
-    message += lineName;
-    message += String(DELIM);
-    message += getLineTypeStr(lineType);
-    message += String(DELIM);
-    message += color;
-    message += String(END_DELIM);
-    return message;
-}
+bool DashioDevice::writeEventLogMessage(MessageWriter& writer, const char *controlID, bool (*getEvent)(int index, EventEntry& event)) {
+    writeControlBaseMessage(writer, EVENT_LOG_ID, controlID);
+    writer.add(dashboardID);
+    writer.add(DELIM);
 
-String DashioDevice::getTimeGraphLineFloats(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, String times[], float lineData[], int dataLength, bool breakLine) {
-    String message = getControlBaseMessage(TIME_GRAPH_ID, controlID);
-    message += dashboardID;
-    message += String(DELIM);
-    message += graphLineID;
-    message += String(DELIM);
-    message += lineName;
-    message += String(DELIM);
-    message += getLineTypeStr(lineType);
-    message += String(DELIM);
-    message += color;
+    EventEntry event;
+    for (int i = 0; getEvent(i, event); i++) {
+        if (i > 0) {
+            writer.add(DELIM);
+        }
+        writeEventEntryJSON(writer, event);
+        event = EventEntry();
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeBasicConfigData(MessageWriter& writer, ControlType controlType, const char *controlID, const char *controlTitle) {
+    writer.add(DELIM);
+    writer.add(getControlTypeID(controlType));
+    writer.add(DELIM);
+    writer.add(controlID);
+    writer.add(DELIM);
+    writer.add(controlTitle);
+    return !writer.overflow();
+}
+
+bool DashioDevice::writeBasicConfigMessage(MessageWriter& writer, ControlType controlType, const char *controlID, const char *controlTitle) {
+    writeDeviceMessage(writer, CONFIG_ID);
+    writer.add(DELIM);
+    writer.add(BASIC_CONFIG_ID);
+    writeBasicConfigData(writer, controlType, controlID, controlTitle);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeGraphLineInts(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const int lineData[], int dataLength) {
+    writeControlBaseMessage(writer, GRAPH_ID, controlID);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(lineName);
+    writer.add(DELIM);
+    writer.add(getLineTypeStr(lineType));
+    writer.add(DELIM);
+    writer.add(color);
+    for (int i = 0; i < dataLength; i++) {
+        writer.add(DELIM);
+        writer.addInt(lineData[i]);
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeGraphLineFloats(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const float lineData[], int dataLength) {
+    writeControlBaseMessage(writer, GRAPH_ID, controlID);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(lineName);
+    writer.add(DELIM);
+    writer.add(getLineTypeStr(lineType));
+    writer.add(DELIM);
+    writer.add(color);
+    for (int i = 0; i < dataLength; i++) {
+        writer.add(DELIM);
+        writer.addFloat(lineData[i]);
+    }
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTimeGraphLine(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color) {
+    writeControlBaseMessage(writer, TIME_GRAPH_ID, controlID);
+    writer.add(BROADCAST_ID);
+    writer.add(DELIM);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(lineName);
+    writer.add(DELIM);
+    writer.add(getLineTypeStr(lineType));
+    writer.add(DELIM);
+    writer.add(color);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTimeGraphLineFloats(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const String times[], const float lineData[], int dataLength, bool breakLine) {
+    writeControlBaseMessage(writer, TIME_GRAPH_ID, controlID);
+    writer.add(dashboardID);
+    writer.add(DELIM);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(lineName);
+    writer.add(DELIM);
+    writer.add(getLineTypeStr(lineType));
+    writer.add(DELIM);
+    writer.add(color);
     if (breakLine && (dataLength > 0)) {
-        message += String(DELIM);
-        message += times[0];
-        message += ",";
-        message += "B";
+        writer.add(DELIM);
+        writer.add(times[0]);
+        writer.add(",B");
     }
     for (int i = 0; i < dataLength; i++) {
-        message += String(DELIM);
-        message += times[i];
-        message += ",";
-        message += formatFloat(lineData[i]);
+        writer.add(DELIM);
+        writer.add(times[i]);
+        writer.add(',');
+        writer.addFloat(lineData[i]);
     }
-    message += String(END_DELIM);
-    return message;
-}
-
-String DashioDevice::getTimeGraphPoint(const String& controlID, const String& graphLineID, float value) {
-    String message = getControlBaseMessage(TIME_GRAPH_ID, controlID);
-    message += graphLineID;
-    message += String(DELIM);
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
-}
-
-String DashioDevice::getTimeGraphPoint(const String& controlID, const String& graphLineID, String time, float value) {
-    String message = getControlBaseMessage(TIME_GRAPH_ID, controlID);
-    message += dashboardID;
-    message += String(DELIM);
-    message += graphLineID;
-    message += String(DELIM);
-    message += time;
-    message += ",";
-    message += formatFloat(value);
-    message += String(END_DELIM);
-    return message;
-}
-
-String DashioDevice::getTimeGraphLineBools(const String& controlID, const String& graphLineID, const String& lineName, LineType lineType, const String& color, String times[], bool lineData[], int dataLength) {
-    String message = getControlBaseMessage(TIME_GRAPH_ID, controlID);
-    message += graphLineID;
-    message += String(DELIM);
-    message += lineName;
-    message += String(DELIM);
-    message += getLineTypeStr(lineType);
-    message += String(DELIM);
-    message += color;
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTimeGraphPoint(MessageWriter& writer, const char *controlID, const char *graphLineID, float value) {
+    writeControlBaseMessage(writer, TIME_GRAPH_ID, controlID);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTimeGraphPoint(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *time, float value) {
+    writeControlBaseMessage(writer, TIME_GRAPH_ID, controlID);
+    writer.add(dashboardID);
+    writer.add(DELIM);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(time);
+    writer.add(',');
+    writer.addFloat(value);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeTimeGraphLineBools(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const String times[], const bool lineData[], int dataLength) {
+    writeControlBaseMessage(writer, TIME_GRAPH_ID, controlID);
+    writer.add(graphLineID);
+    writer.add(DELIM);
+    writer.add(lineName);
+    writer.add(DELIM);
+    writer.add(getLineTypeStr(lineType));
+    writer.add(DELIM);
+    writer.add(color);
     for (int i = 0; i < dataLength; i++) {
-        message += String(DELIM);
-        message += times[i];
-        message += ",";
+        writer.add(DELIM);
+        writer.add(times[i]);
+        writer.add(',');
         if (lineData[i]) {
-            message += "T";
+            writer.add('T');
         } else {
-            message += "F";
+            writer.add('F');
         }
     }
-    message += String(END_DELIM);
-    return message;
+    return endMessage(writer);
 }
 
 String DashioDevice::getControlTypeStr(ControlType controltype) {
-    switch (controltype) {
-        case connect: return CONNECT_ID;
-        case who: return WHO_ID;
-        case status: return STATUS_ID;
-        case config: return CONFIG_ID;
-              
-        case device: return DEVICE_ID;
-        case deviceView: return DEVICE_VIEW_ID;
-        case label: return LABEL_ID;
-        case button: return BUTTON_ID;
-        case menu: return MENU_ID;
-        case buttonGroup: return BUTTON_GROUP_ID;
-        case eventLog: return EVENT_LOG_ID;
-        case slider: return SLIDER_ID;
-        case knob: return KNOB_ID;
-        case dial: return DIAL_ID;
-        case direction: return DIRECTION_ID;
-        case textBox: return TEXT_BOX_ID;
-        case selector: return SELECTOR_ID;
-        case graph: return GRAPH_ID;
-        case timeGraph: return TIME_GRAPH_ID;
-        case mapper: return MAP_ID;
-        case colorPicker: return COLOR_ID;
-        case audioVisual: return AV_ID;
-              
-        case deviceName: return DEVICE_NAME_ID;
-        case wifiSetup: return WIFI_SETUP_ID;
-        case tcpSetup: return TCP_SETUP_ID;
-        case dashioSetup: return DASHIO_SETUP_ID;
-        case mqttSetup: return MQTT_SETUP_ID;
-
-        case mqttConn: return MQTT_CONNECTION_ID;
-        case bleConn: return BLE_CONNECTION_ID;
-        case tcpConn: return TCP_CONNECTION_ID;
-              
-        case alarmNotify: return ALARM_ID;
-
-        case pushToken: return "";
-        case unknown: return "";
-    }
-    return "";
+    return getControlTypeID(controltype);
+}
+
+const char * DashioDevice::getControlTypeID(ControlType controltype) {
+    if (controltype > unknown) {
+        return "";
+    }
+    return controlTypes[controltype].id;
 }
 
 String DashioDevice::getMQTTSubscribeTopic(const String& userName) {
@@ -926,7 +1553,76 @@ String DashioDevice::getMQTTTopic(const String& userName, MQTTTopicType topic) {
     return userName + "/" + deviceID + "/" + tip;
 }
 
-String DashioDevice::getLineTypeStr(LineType lineType) {
+const String& DashioDevice::getDeviceID() {
+    return deviceID;
+}
+
+#ifndef ARDUINO_ARCH_AVR
+// deviceID is public, so a sketch may change it without setup(). The cache is checked against it before each use.
+bool DashioDevice::isDeviceHeaderCurrent() {
+    return (deviceHeaderLength == deviceID.length() + 2) && (memcmp(deviceHeader + 1, deviceID.c_str(), deviceID.length()) == 0);
+}
+
+void DashioDevice::updateDeviceHeader() {
+    // Cache "\t<deviceID>\t" so that each message only has to copy the prefix
+    deviceHeaderLength = 0;
+    if (deviceID.length() + 3 > sizeof(deviceHeader)) {
+        return; // Too long to cache, so writeDeviceHeader builds it each time
+    }
+    deviceHeader[0] = DELIM;
+    memcpy(deviceHeader + 1, deviceID.c_str(), deviceID.length());
+    deviceHeaderLength = deviceID.length() + 2;
+    deviceHeader[deviceHeaderLength - 1] = DELIM;
+    deviceHeader[deviceHeaderLength] = '\0';
+}
+#endif
+
+void DashioDevice::writeDeviceHeader(MessageWriter& writer) {
+#ifndef ARDUINO_ARCH_AVR
+    if (!isDeviceHeaderCurrent()) {
+        updateDeviceHeader();
+    }
+    if (deviceHeaderLength > 0) {
+        writer.add(deviceHeader, deviceHeaderLength);
+        return;
+    }
+#endif
+    writer.add(DELIM);
+    writer.add(deviceID);
+    writer.add(DELIM);
+}
+
+void DashioDevice::writeDeviceMessage(MessageWriter& writer, const char *messageType) {
+    writeDeviceHeader(writer);
+    writer.add(messageType);
+}
+
+void DashioDevice::writeControlBaseMessage(MessageWriter& writer, const char *controlType, const char *controlID) {
+    writeDeviceMessage(writer, controlType);
+    writer.add(DELIM);
+    writer.add(controlID);
+    writer.add(DELIM);
+}
+
+void DashioDevice::writeFullConfigHeader(MessageWriter& writer, ControlType controlType) {
+    writeDeviceMessage(writer, CONFIG_ID);
+    writer.add(DELIM);
+    if (writingBroadcastConfig) {
+        writer.add(BROADCAST_ID);
+    } else {
+        writer.add(dashboardID);
+    }
+    writer.add(DELIM);
+    writer.add(getControlTypeID(controlType));
+    writer.add(DELIM);
+}
+
+bool DashioDevice::endMessage(MessageWriter& writer) {
+    writer.add(END_DELIM);
+    return !writer.overflow();
+}
+
+const char * DashioDevice::getLineTypeStr(LineType lineType) {
     switch (lineType) {
         case line:
             return LINE_ID;
@@ -943,106 +1639,470 @@ String DashioDevice::getLineTypeStr(LineType lineType) {
     }
 }
 
-String DashioDevice::getIntArray(const String& controlType, const String& ID, int idata[], int dataLength) {
-    String writeStr = String(DELIM);
-    writeStr += deviceID;
-    writeStr + String(DELIM);
-    writeStr + controlType;
-    writeStr + String(DELIM);
-    writeStr + ID;
+bool DashioDevice::writeIntArray(MessageWriter& writer, const char *controlType, const char *ID, const int idata[], int dataLength) {
+    writeDeviceMessage(writer, controlType);
+    writer.add(DELIM);
+    writer.add(ID);
     for (int i = 0; i < dataLength; i++) {
-        writeStr += String(DELIM);
-        writeStr += formatInt(idata[i]);
+        writer.add(DELIM);
+        writer.addInt(idata[i]);
     }
-    writeStr += String(END_DELIM);
-    return writeStr;
+    return endMessage(writer);
 }
 
-String DashioDevice::getFloatArray(const String& controlType, const String& ID, float fdata[], int dataLength) {
-    String writeStr = String(DELIM);
-    writeStr + deviceID;
-    writeStr + String(DELIM);
-    writeStr + controlType;
-    writeStr + String(DELIM);
-    writeStr + ID;
+bool DashioDevice::writeFloatArray(MessageWriter& writer, const char *controlType, const char *ID, const float fdata[], int dataLength) {
+    writeDeviceMessage(writer, controlType);
+    writer.add(DELIM);
+    writer.add(ID);
     for (int i = 0; i < dataLength; i++) {
-        writeStr += String(DELIM);
-        writeStr += formatFloat(fdata[i]);
+        writer.add(DELIM);
+        writer.addFloat(fdata[i]);
     }
-    writeStr += String(END_DELIM);
-    return writeStr;
+    return endMessage(writer);
+}
+
+// Config descriptors
+CommonControlDesc::CommonControlDesc(const CommonControl& cfg) {
+    controlID = cfg.controlID.c_str();
+    parentID = cfg.parentID.c_str();
+    title = cfg.title.c_str();
+    titlePosition = cfg.titlePosition;
+    graphicsRect = cfg.graphicsRect;
+}
+
+DeviceDesc::DeviceDesc(const DeviceCfg& cfg) {
+    numDeviceViews = cfg.numDeviceViews;
+    deviceSetup = cfg.deviceSetup.c_str();
+}
+
+DeviceViewDesc::DeviceViewDesc(const DeviceViewCfg& cfg) {
+    controlID = cfg.controlID.c_str();
+    title = cfg.title.c_str();
+    iconName = cfg.iconName.c_str();
+    color = cfg.color.c_str();
+    shareColumn = cfg.shareColumn;
+    numColumns = cfg.numColumns;
+    ctrlMaxFontSize = cfg.ctrlMaxFontSize;
+    ctrlBorderOn = cfg.ctrlBorderOn;
+    ctrlBorderColor = cfg.ctrlBorderColor.c_str();
+    ctrlColor = cfg.ctrlColor.c_str();
+    ctrlBkgndColor = cfg.ctrlBkgndColor.c_str();
+    ctrlBkgndTransparency = cfg.ctrlBkgndTransparency;
+    ctrlTitleFontSize = cfg.ctrlTitleFontSize;
+    ctrlTitleBoxColor = cfg.ctrlTitleBoxColor.c_str();
+    ctrlTitleBoxTransparency = cfg.ctrlTitleBoxTransparency;
+}
+
+AlarmDesc::AlarmDesc(const AlarmCfg& cfg) {
+    controlID = cfg.controlID.c_str();
+    description = cfg.description.c_str();
+    soundName = cfg.soundName.c_str();
+}
+
+LabelDesc::LabelDesc(const LabelCfg& cfg) : CommonControlDesc(cfg) {
+    style = cfg.style;
+    color = cfg.color.c_str();
+}
+
+ButtonDesc::ButtonDesc(const ButtonCfg& cfg) : CommonControlDesc(cfg) {
+    buttonEnabled = cfg.buttonEnabled;
+    iconName = cfg.iconName.c_str();
+    text = cfg.text.c_str();
+    offColor = cfg.offColor.c_str();
+    onColor = cfg.onColor.c_str();
+}
+
+MenuDesc::MenuDesc(const MenuCfg& cfg) : CommonControlDesc(cfg) {
+    iconName = cfg.iconName.c_str();
+    text = cfg.text.c_str();
+}
+
+ButtonGroupDesc::ButtonGroupDesc(const ButtonGroupCfg& cfg) : CommonControlDesc(cfg) {
+    iconName = cfg.iconName.c_str();
+    text = cfg.text.c_str();
+    gridView = cfg.gridView;
+}
+
+EventLogDesc::EventLogDesc(const EventLogCfg& cfg) : CommonControlDesc(cfg) {
+}
+
+KnobDesc::KnobDesc(const KnobCfg& cfg) : CommonControlDesc(cfg) {
+    min = cfg.min;
+    max = cfg.max;
+    redValue = cfg.redValue;
+    showMinMax = cfg.showMinMax;
+    style = cfg.style;
+    knobColor = cfg.knobColor.c_str();
+    sendOnlyOnRelease = cfg.sendOnlyOnRelease;
+    dialFollowsKnob = cfg.dialFollowsKnob;
+    dialColor = cfg.dialColor.c_str();
+}
+
+DialDesc::DialDesc(const DialCfg& cfg) : CommonControlDesc(cfg) {
+    min = cfg.min;
+    max = cfg.max;
+    redValue = cfg.redValue;
+    dialFillColor = cfg.dialFillColor.c_str();
+    pointerColor = cfg.pointerColor.c_str();
+    numberPosition = cfg.numberPosition;
+    showMinMax = cfg.showMinMax;
+    style = cfg.style;
+    units = cfg.units.c_str();
+    precision = cfg.precision;
+}
+
+DirectionDesc::DirectionDesc(const DirectionCfg& cfg) : CommonControlDesc(cfg) {
+    pointerColor = cfg.pointerColor.c_str();
+    style = cfg.style;
+    calAngle = cfg.calAngle;
+    units = cfg.units.c_str();
+    precision = cfg.precision;
+}
+
+TextBoxDesc::TextBoxDesc(const TextBoxCfg& cfg) : CommonControlDesc(cfg) {
+    format = cfg.format;
+    textAlign = cfg.textAlign;
+    units = cfg.units.c_str();
+    precision = cfg.precision;
+    kbdType = cfg.kbdType;
+    closeKbdOnSend = cfg.closeKbdOnSend;
+}
+
+SelectorDesc::SelectorDesc(const SelectorCfg& cfg) : CommonControlDesc(cfg) {
+}
+
+SliderDesc::SliderDesc(const SliderCfg& cfg) : CommonControlDesc(cfg) {
+    min = cfg.min;
+    max = cfg.max;
+    redValue = cfg.redValue;
+    showMinMax = cfg.showMinMax;
+    sliderEnabled = cfg.sliderEnabled;
+    knobColor = cfg.knobColor.c_str();
+    sendOnlyOnRelease = cfg.sendOnlyOnRelease;
+    barFollowsSlider = cfg.barFollowsSlider;
+    barColor = cfg.barColor.c_str();
+    barStyle = cfg.barStyle;
+}
+
+GraphDesc::GraphDesc(const GraphCfg& cfg) : CommonControlDesc(cfg) {
+    xAxisLabel = cfg.xAxisLabel.c_str();
+    xAxisMin = cfg.xAxisMin;
+    xAxisMax = cfg.xAxisMax;
+    xAxisNumBars = cfg.xAxisNumBars;
+    xAxisLabelsStyle = cfg.xAxisLabelsStyle;
+    yAxisLabel = cfg.yAxisLabel.c_str();
+    yAxisMin = cfg.yAxisMin;
+    yAxisMax = cfg.yAxisMax;
+    yAxisNumBars = cfg.yAxisNumBars;
+}
+
+TimeGraphDesc::TimeGraphDesc(const TimeGraphCfg& cfg) : CommonControlDesc(cfg) {
+    yAxisLabel = cfg.yAxisLabel.c_str();
+    yAxisMin = cfg.yAxisMin;
+    yAxisMax = cfg.yAxisMax;
+    yAxisNumBars = cfg.yAxisNumBars;
+}
+
+MapDesc::MapDesc(const MapCfg& cfg) : CommonControlDesc(cfg) {
+}
+
+ColorDesc::ColorDesc(const ColorCfg& cfg) : CommonControlDesc(cfg) {
+    pickerStyle = cfg.pickerStyle;
+    sendOnlyOnRelease = cfg.sendOnlyOnRelease;
+}
+
+AudioVisualDesc::AudioVisualDesc(const AudioVisualCfg& cfg) : CommonControlDesc(cfg) {
 }
 
 // Configuration
-String DashioDevice::getConfigMessage(DeviceCfg deviceConfigData) {
-    DashJSON json;
+String DashioDevice::getConfigMessage(const DeviceCfg& deviceConfigData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, deviceConfigData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const DeviceViewCfg& deviceViewData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, deviceViewData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const BLEConnCfg& connectionData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, connectionData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const TCPConnCfg& connectionData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, connectionData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const MQTTConnCfg& connectionData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, connectionData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const AlarmCfg& alarmData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, alarmData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const LabelCfg& labelData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, labelData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const ButtonCfg& buttonData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, buttonData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const MenuCfg& menuData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, menuData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const ButtonGroupCfg& groupData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, groupData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const EventLogCfg& eventLogData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, eventLogData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const KnobCfg& knobData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, knobData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const DialCfg& dialData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, dialData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const DirectionCfg& directionData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, directionData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const TextBoxCfg& textBoxData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, textBoxData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const SelectorCfg& selectorData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, selectorData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const SliderCfg& sliderData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, sliderData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const GraphCfg& graphData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, graphData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const TimeGraphCfg& timeGraphData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, timeGraphData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const MapCfg& mapData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, mapData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const ColorCfg& colorData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, colorData);
+    });
+}
+
+String DashioDevice::getConfigMessage(const AudioVisualCfg& avData) {
+    return getMeasuredMessage([&](MessageWriter& writer) {
+        writeConfigMessage(writer, avData);
+    });
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DeviceCfg& deviceConfigData) {
+    return writeConfigMessage(writer, DeviceDesc(deviceConfigData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DeviceDesc& deviceConfigData) {
+    writeFullConfigHeader(writer, device);
+    DashJSON json(writer);
     json.start();
     json.addKeyInt(F("numDeviceViews"), deviceConfigData.numDeviceViews);
     json.addKeyString(F("deviceSetup"), deviceConfigData.deviceSetup, true);
-    return getFullConfigMessage(device, json.jsonStr);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DeviceViewCfg& deviceViewData) {
+    return writeConfigMessage(writer, DeviceViewDesc(deviceViewData));
 }
 
-String DashioDevice::getConfigMessage(DeviceViewCfg deviceViewData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DeviceViewDesc& deviceViewData) {
+    writeFullConfigHeader(writer, deviceView);
+    const DeviceViewDesc defaults("", "", "", "black");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), deviceViewData.controlID);
     json.addKeyString(F("title"), deviceViewData.title);
     json.addKeyString(F("iconName"), deviceViewData.iconName);
-    json.addKeyString(F("color"), deviceViewData.color);
-    json.addKeyBool(F("shareColumn"), deviceViewData.shareColumn);
-    json.addKeyInt(F("numColumns"), deviceViewData.numColumns);
+    json.addOptionalString(F("color"), deviceViewData.color, defaults.color);
+    json.addOptionalBool(F("shareColumn"), deviceViewData.shareColumn, defaults.shareColumn);
+    json.addOptionalInt(F("numColumns"), deviceViewData.numColumns, defaults.numColumns);
 
     // Control Default Values
-    json.addKeyInt(F("ctrlMaxFontSize"), deviceViewData.ctrlMaxFontSize);
-    json.addKeyBool(F("ctrlBorderOn"), deviceViewData.ctrlBorderOn);
-    json.addKeyString(F("ctrlBorderColor"), deviceViewData.ctrlBorderColor);
-    json.addKeyString(F("ctrlColor"), deviceViewData.ctrlColor);
-    json.addKeyString(F("ctrlBkgndColor"), deviceViewData.ctrlBkgndColor);
-    json.addKeyInt(F("ctrlBkgndTransparency"), deviceViewData.ctrlBkgndTransparency);
+    json.addOptionalInt(F("ctrlMaxFontSize"), deviceViewData.ctrlMaxFontSize, defaults.ctrlMaxFontSize);
+    json.addOptionalBool(F("ctrlBorderOn"), deviceViewData.ctrlBorderOn, defaults.ctrlBorderOn);
+    json.addOptionalString(F("ctrlBorderColor"), deviceViewData.ctrlBorderColor, defaults.ctrlBorderColor);
+    json.addOptionalString(F("ctrlColor"), deviceViewData.ctrlColor, defaults.ctrlColor);
+    json.addOptionalString(F("ctrlBkgndColor"), deviceViewData.ctrlBkgndColor, defaults.ctrlBkgndColor);
+    json.addOptionalInt(F("ctrlBkgndTransparency"), deviceViewData.ctrlBkgndTransparency, defaults.ctrlBkgndTransparency);
 
     // Control Title Box Default Values
-    json.addKeyInt(F("ctrlTitleFontSize"), deviceViewData.ctrlTitleFontSize);
-    json.addKeyString(F("ctrlTitleBoxColor"), deviceViewData.ctrlTitleBoxColor);
-    json.addKeyInt(F("ctrlTitleBoxTransparency"), deviceViewData.ctrlTitleBoxTransparency, true);
-    return getFullConfigMessage(deviceView, json.jsonStr);
+    json.addOptionalInt(F("ctrlTitleFontSize"), deviceViewData.ctrlTitleFontSize, defaults.ctrlTitleFontSize);
+    json.addOptionalString(F("ctrlTitleBoxColor"), deviceViewData.ctrlTitleBoxColor, defaults.ctrlTitleBoxColor);
+    json.addOptionalInt(F("ctrlTitleBoxTransparency"), deviceViewData.ctrlTitleBoxTransparency, defaults.ctrlTitleBoxTransparency, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(BLEConnCfg connectionData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const BLEConnCfg& connectionData) {
+    writeFullConfigHeader(writer, bleConn);
+    DashJSON json(writer);
     json.start();
-    json.addKeyString(F("serviceUUID"), connectionData.serviceUUID);
-    json.addKeyString(F("readUUID"), connectionData.readUUID);
-    json.addKeyString(F("writeUUID"), connectionData.writeUUID, true);
-    return getFullConfigMessage(bleConn, json.jsonStr);
+    json.addKeyString(F("serviceUUID"), connectionData.serviceUUID.c_str());
+    json.addKeyString(F("readUUID"), connectionData.readUUID.c_str());
+    json.addKeyString(F("writeUUID"), connectionData.writeUUID.c_str(), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(TCPConnCfg connectionData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const TCPConnCfg& connectionData) {
+    writeFullConfigHeader(writer, tcpConn);
+    DashJSON json(writer);
     json.start();
-    json.addKeyString(F("ipAddress"), connectionData.ipAddress);
+    json.addKeyString(F("ipAddress"), connectionData.ipAddress.c_str());
     json.addKeyInt(F("port"), connectionData.port, true);
-    return getFullConfigMessage(tcpConn, json.jsonStr);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(MQTTConnCfg connectionData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const MQTTConnCfg& connectionData) {
+    writeFullConfigHeader(writer, mqttConn);
+    DashJSON json(writer);
     json.start();
-    json.addKeyString(F("userName"), connectionData.userName);
-    json.addKeyString(F("hostURL"), connectionData.hostURL, true);
-    return getFullConfigMessage(mqttConn, json.jsonStr);
+    json.addKeyString(F("userName"), connectionData.userName.c_str());
+    json.addKeyString(F("hostURL"), connectionData.hostURL.c_str(), true);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const AlarmCfg& alarmData) {
+    return writeConfigMessage(writer, AlarmDesc(alarmData));
 }
 
-String DashioDevice::getConfigMessage(AlarmCfg alarmData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const AlarmDesc& alarmData) {
+    writeFullConfigHeader(writer, alarmNotify);
+    DashJSON json(writer);
     json.start();
     json.addKeyString(F("controlID"), alarmData.controlID);
     json.addKeyString(F("description"), alarmData.description);
     json.addKeyString(F("soundName"), alarmData.soundName, true);
-    return getFullConfigMessage(alarmNotify, json.jsonStr);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const LabelCfg& labelData) {
+    return writeConfigMessage(writer, LabelDesc(labelData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ButtonCfg& buttonData) {
+    return writeConfigMessage(writer, ButtonDesc(buttonData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const MenuCfg& menuData) {
+    return writeConfigMessage(writer, MenuDesc(menuData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ButtonGroupCfg& groupData) {
+    return writeConfigMessage(writer, ButtonGroupDesc(groupData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const EventLogCfg& eventLogData) {
+    return writeConfigMessage(writer, EventLogDesc(eventLogData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const KnobCfg& knobData) {
+    return writeConfigMessage(writer, KnobDesc(knobData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DialCfg& dialData) {
+    return writeConfigMessage(writer, DialDesc(dialData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DirectionCfg& directionData) {
+    return writeConfigMessage(writer, DirectionDesc(directionData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const TextBoxCfg& textBoxData) {
+    return writeConfigMessage(writer, TextBoxDesc(textBoxData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const SelectorCfg& selectorData) {
+    return writeConfigMessage(writer, SelectorDesc(selectorData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const SliderCfg& sliderData) {
+    return writeConfigMessage(writer, SliderDesc(sliderData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const GraphCfg& graphData) {
+    return writeConfigMessage(writer, GraphDesc(graphData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const TimeGraphCfg& timeGraphData) {
+    return writeConfigMessage(writer, TimeGraphDesc(timeGraphData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const MapCfg& mapData) {
+    return writeConfigMessage(writer, MapDesc(mapData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ColorCfg& colorData) {
+    return writeConfigMessage(writer, ColorDesc(colorData));
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const AudioVisualCfg& avData) {
+    return writeConfigMessage(writer, AudioVisualDesc(avData));
 }
 
-String DashioDevice::getConfigMessage(LabelCfg labelData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const LabelDesc& labelData) {
+    writeFullConfigHeader(writer, label);
+    const LabelDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), labelData.controlID);
     json.addKeyString(F("parentID"), labelData.parentID);
@@ -1051,15 +2111,18 @@ String DashioDevice::getConfigMessage(LabelCfg labelData) {
     json.addKeyFloat(F("widthRatio"), labelData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), labelData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), labelData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(labelData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(labelData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyString(F("style"), getLabelStyle(labelData.style));
-    json.addKeyString(F("color"), labelData.color, true);
-    return getFullConfigMessage(label, json.jsonStr);
+    json.addOptionalString(F("style"), getLabelStyle(labelData.style), getLabelStyle(defaults.style));
+    json.addOptionalString(F("color"), labelData.color, defaults.color, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(ButtonCfg buttonData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ButtonDesc& buttonData) {
+    writeFullConfigHeader(writer, button);
+    const ButtonDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), buttonData.controlID);
     json.addKeyString(F("parentID"), buttonData.parentID);
@@ -1068,18 +2131,21 @@ String DashioDevice::getConfigMessage(ButtonCfg buttonData) {
     json.addKeyFloat(F("widthRatio"), buttonData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), buttonData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), buttonData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(buttonData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(buttonData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyBool(F("buttonEnabled"), buttonData.buttonEnabled);
+    json.addOptionalBool(F("buttonEnabled"), buttonData.buttonEnabled, defaults.buttonEnabled);
     json.addKeyString(F("iconName"), buttonData.iconName);
     json.addKeyString(F("text"), buttonData.text);
-    json.addKeyString(F("offColor"), buttonData.offColor);
-    json.addKeyString(F("onColor"), buttonData.onColor, true);
-    return getFullConfigMessage(button, json.jsonStr);
+    json.addOptionalString(F("offColor"), buttonData.offColor, defaults.offColor);
+    json.addOptionalString(F("onColor"), buttonData.onColor, defaults.onColor, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(MenuCfg menuData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const MenuDesc& menuData) {
+    writeFullConfigHeader(writer, menu);
+    const MenuDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), menuData.controlID);
     json.addKeyString(F("parentID"), menuData.parentID);
@@ -1088,15 +2154,18 @@ String DashioDevice::getConfigMessage(MenuCfg menuData) {
     json.addKeyFloat(F("widthRatio"), menuData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), menuData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), menuData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(menuData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(menuData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyString(F("iconName"), menuData.iconName);
+    json.addOptionalString(F("iconName"), menuData.iconName, defaults.iconName);
     json.addKeyString(F("text"), menuData.text, true);
-    return getFullConfigMessage(menu, json.jsonStr);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(ButtonGroupCfg groupData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ButtonGroupDesc& groupData) {
+    writeFullConfigHeader(writer, buttonGroup);
+    const ButtonGroupDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), groupData.controlID);
     json.addKeyString(F("parentID"), groupData.parentID);
@@ -1105,16 +2174,19 @@ String DashioDevice::getConfigMessage(ButtonGroupCfg groupData) {
     json.addKeyFloat(F("widthRatio"), groupData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), groupData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), groupData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(groupData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(groupData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyString(F("iconName"), groupData.iconName);
+    json.addOptionalString(F("iconName"), groupData.iconName, defaults.iconName);
     json.addKeyString(F("text"), groupData.text);
-    json.addKeyBool(F("gridView"), groupData.gridView, true);
-    return getFullConfigMessage(buttonGroup, json.jsonStr);
+    json.addOptionalBool(F("gridView"), groupData.gridView, defaults.gridView, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(EventLogCfg eventLogData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const EventLogDesc& eventLogData) {
+    writeFullConfigHeader(writer, eventLog);
+    const EventLogDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), eventLogData.controlID);
     json.addKeyString(F("parentID"), eventLogData.parentID);
@@ -1123,12 +2195,15 @@ String DashioDevice::getConfigMessage(EventLogCfg eventLogData) {
     json.addKeyFloat(F("widthRatio"), eventLogData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), eventLogData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), eventLogData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(eventLogData.titlePosition), true);
-    return getFullConfigMessage(eventLog, json.jsonStr);
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(eventLogData.titlePosition), getTitlePositionStr(defaults.titlePosition), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(KnobCfg knobData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const KnobDesc& knobData) {
+    writeFullConfigHeader(writer, knob);
+    const KnobDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), knobData.controlID);
     json.addKeyString(F("parentID"), knobData.parentID);
@@ -1137,22 +2212,25 @@ String DashioDevice::getConfigMessage(KnobCfg knobData) {
     json.addKeyFloat(F("widthRatio"), knobData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), knobData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), knobData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(knobData.titlePosition));
-
-    json.addKeyFloat(F("min"), knobData.min);
-    json.addKeyFloat(F("max"), knobData.max);
-    json.addKeyFloat(F("redValue"), knobData.redValue);
-    json.addKeyBool(F("showMinMax"), knobData.showMinMax);
-    json.addKeyString(F("style"), getKnobPresentationStyle(knobData.style));
-    json.addKeyString(F("knobColor"), knobData.knobColor);
-    json.addKeyBool(F("sendOnlyOnRelease"), knobData.sendOnlyOnRelease);
-    json.addKeyBool(F("dialFollowsKnob"), knobData.dialFollowsKnob);
-    json.addKeyString(F("dialColor"), knobData.dialColor, true);
-    return getFullConfigMessage(knob, json.jsonStr);
-}
-
-String DashioDevice::getConfigMessage(DialCfg dialData) {
-    DashJSON json;
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(knobData.titlePosition), getTitlePositionStr(defaults.titlePosition));
+
+    json.addOptionalFloat(F("min"), knobData.min, defaults.min);
+    json.addOptionalFloat(F("max"), knobData.max, defaults.max);
+    json.addOptionalFloat(F("redValue"), knobData.redValue, defaults.redValue);
+    json.addOptionalBool(F("showMinMax"), knobData.showMinMax, defaults.showMinMax);
+    json.addOptionalString(F("style"), getKnobPresentationStyle(knobData.style), getKnobPresentationStyle(defaults.style));
+    json.addOptionalString(F("knobColor"), knobData.knobColor, defaults.knobColor);
+    json.addOptionalBool(F("sendOnlyOnRelease"), knobData.sendOnlyOnRelease, defaults.sendOnlyOnRelease);
+    json.addOptionalBool(F("dialFollowsKnob"), knobData.dialFollowsKnob, defaults.dialFollowsKnob);
+    json.addOptionalString(F("dialColor"), knobData.dialColor, defaults.dialColor, true);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DialDesc& dialData) {
+    writeFullConfigHeader(writer, dial);
+    const DialDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), dialData.controlID);
     json.addKeyString(F("parentID"), dialData.parentID);
@@ -1161,23 +2239,26 @@ String DashioDevice::getConfigMessage(DialCfg dialData) {
     json.addKeyFloat(F("widthRatio"), dialData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), dialData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), dialData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(dialData.titlePosition));
-
-    json.addKeyFloat(F("min"), dialData.min);
-    json.addKeyFloat(F("max"), dialData.max);
-    json.addKeyFloat(F("redValue"), dialData.redValue);
-    json.addKeyString(F("dialFillColor"), dialData.dialFillColor);
-    json.addKeyString(F("pointerColor"), dialData.pointerColor);
-    json.addKeyString(F("numberPosition"), getDialNumberPosition(dialData.numberPosition));
-    json.addKeyBool(F("showMinMax"), dialData.showMinMax);
-    json.addKeyString(F("style"), getDialPresentationStyle(dialData.style));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(dialData.titlePosition), getTitlePositionStr(defaults.titlePosition));
+
+    json.addOptionalFloat(F("min"), dialData.min, defaults.min);
+    json.addOptionalFloat(F("max"), dialData.max, defaults.max);
+    json.addOptionalFloat(F("redValue"), dialData.redValue, defaults.redValue);
+    json.addOptionalString(F("dialFillColor"), dialData.dialFillColor, defaults.dialFillColor);
+    json.addOptionalString(F("pointerColor"), dialData.pointerColor, defaults.pointerColor);
+    json.addOptionalString(F("numberPosition"), getDialNumberPosition(dialData.numberPosition), getDialNumberPosition(defaults.numberPosition));
+    json.addOptionalBool(F("showMinMax"), dialData.showMinMax, defaults.showMinMax);
+    json.addOptionalString(F("style"), getDialPresentationStyle(dialData.style), getDialPresentationStyle(defaults.style));
     json.addKeyString(F("units"), dialData.units);
-    json.addKeyInt(F("precision"), dialData.precision, true);
-    return getFullConfigMessage(dial, json.jsonStr);
+    json.addOptionalInt(F("precision"), dialData.precision, defaults.precision, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(DirectionCfg directionData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const DirectionDesc& directionData) {
+    writeFullConfigHeader(writer, direction);
+    const DirectionDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), directionData.controlID);
     json.addKeyString(F("parentID"), directionData.parentID);
@@ -1186,18 +2267,21 @@ String DashioDevice::getConfigMessage(DirectionCfg directionData) {
     json.addKeyFloat(F("widthRatio"), directionData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), directionData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), directionData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(directionData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(directionData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyString(F("pointerColor"), directionData.pointerColor);
-    json.addKeyString(F("style"), getDirectionPresentationStyle(directionData.style));
-    json.addKeyInt(F("calAngle"), directionData.calAngle);
+    json.addOptionalString(F("pointerColor"), directionData.pointerColor, defaults.pointerColor);
+    json.addOptionalString(F("style"), getDirectionPresentationStyle(directionData.style), getDirectionPresentationStyle(defaults.style));
+    json.addOptionalInt(F("calAngle"), directionData.calAngle, defaults.calAngle);
     json.addKeyString(F("units"), directionData.units);
-    json.addKeyInt(F("precision"), directionData.precision, true);
-    return getFullConfigMessage(direction, json.jsonStr);
+    json.addOptionalInt(F("precision"), directionData.precision, defaults.precision, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(TextBoxCfg textBoxData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const TextBoxDesc& textBoxData) {
+    writeFullConfigHeader(writer, textBox);
+    const TextBoxDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), textBoxData.controlID);
     json.addKeyString(F("parentID"), textBoxData.parentID);
@@ -1206,19 +2290,22 @@ String DashioDevice::getConfigMessage(TextBoxCfg textBoxData) {
     json.addKeyFloat(F("widthRatio"), textBoxData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), textBoxData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), textBoxData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(textBoxData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(textBoxData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyString(F("format"), getTextFormatStr(textBoxData.format));
-    json.addKeyString(F("textAlign"), getTextAlignStr(textBoxData.textAlign));
+    json.addOptionalString(F("format"), getTextFormatStr(textBoxData.format), getTextFormatStr(defaults.format));
+    json.addOptionalString(F("textAlign"), getTextAlignStr(textBoxData.textAlign), getTextAlignStr(defaults.textAlign));
     json.addKeyString(F("units"), textBoxData.units);
-    json.addKeyInt(F("precision"), textBoxData.precision);
-    json.addKeyString(F("kbdType"), getKeyboardTypeStr(textBoxData.kbdType));
-    json.addKeyBool(F("closeKbdOnSend"), textBoxData.closeKbdOnSend, true);
-    return getFullConfigMessage(textBox, json.jsonStr);
+    json.addOptionalInt(F("precision"), textBoxData.precision, defaults.precision);
+    json.addOptionalString(F("kbdType"), getKeyboardTypeStr(textBoxData.kbdType), getKeyboardTypeStr(defaults.kbdType));
+    json.addOptionalBool(F("closeKbdOnSend"), textBoxData.closeKbdOnSend, defaults.closeKbdOnSend, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(SelectorCfg selectorData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const SelectorDesc& selectorData) {
+    writeFullConfigHeader(writer, selector);
+    const SelectorDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), selectorData.controlID);
     json.addKeyString(F("parentID"), selectorData.parentID);
@@ -1227,12 +2314,15 @@ String DashioDevice::getConfigMessage(SelectorCfg selectorData) {
     json.addKeyFloat(F("widthRatio"), selectorData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), selectorData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), selectorData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(selectorData.titlePosition), true);
-    return getFullConfigMessage(selector, json.jsonStr);
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(selectorData.titlePosition), getTitlePositionStr(defaults.titlePosition), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(SliderCfg sliderData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const SliderDesc& sliderData) {
+    writeFullConfigHeader(writer, slider);
+    const SliderDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), sliderData.controlID);
     json.addKeyString(F("parentID"), sliderData.parentID);
@@ -1241,23 +2331,26 @@ String DashioDevice::getConfigMessage(SliderCfg sliderData) {
     json.addKeyFloat(F("widthRatio"), sliderData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), sliderData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), sliderData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(sliderData.titlePosition));
-
-    json.addKeyFloat(F("min"), sliderData.min);
-    json.addKeyFloat(F("max"), sliderData.max);
-    json.addKeyFloat(F("redValue"), sliderData.redValue);
-    json.addKeyBool(F("showMinMax"), sliderData.showMinMax);
-    json.addKeyBool(F("sliderEnabled"), sliderData.sliderEnabled);
-    json.addKeyString(F("knobColor"), sliderData.knobColor);
-    json.addKeyBool(F("sendOnlyOnRelease"), sliderData.sendOnlyOnRelease);
-    json.addKeyBool(F("barFollowsSlider"), sliderData.barFollowsSlider);
-    json.addKeyString(F("barColor"), sliderData.barColor);
-    json.addKeyString(F("barStyle"), getBarStyleStr(sliderData.barStyle), true);
-    return getFullConfigMessage(slider, json.jsonStr);
-}
-
-String DashioDevice::getConfigMessage(GraphCfg graphData) {
-    DashJSON json;
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(sliderData.titlePosition), getTitlePositionStr(defaults.titlePosition));
+
+    json.addOptionalFloat(F("min"), sliderData.min, defaults.min);
+    json.addOptionalFloat(F("max"), sliderData.max, defaults.max);
+    json.addOptionalFloat(F("redValue"), sliderData.redValue, defaults.redValue);
+    json.addOptionalBool(F("showMinMax"), sliderData.showMinMax, defaults.showMinMax);
+    json.addOptionalBool(F("sliderEnabled"), sliderData.sliderEnabled, defaults.sliderEnabled);
+    json.addOptionalString(F("knobColor"), sliderData.knobColor, defaults.knobColor);
+    json.addOptionalBool(F("sendOnlyOnRelease"), sliderData.sendOnlyOnRelease, defaults.sendOnlyOnRelease);
+    json.addOptionalBool(F("barFollowsSlider"), sliderData.barFollowsSlider, defaults.barFollowsSlider);
+    json.addOptionalString(F("barColor"), sliderData.barColor, defaults.barColor);
+    json.addOptionalString(F("barStyle"), getBarStyleStr(sliderData.barStyle), getBarStyleStr(defaults.barStyle), true);
+    return endMessage(writer);
+}
+
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const GraphDesc& graphData) {
+    writeFullConfigHeader(writer, graph);
+    const GraphDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), graphData.controlID);
     json.addKeyString(F("parentID"), graphData.parentID);
@@ -1266,22 +2359,25 @@ String DashioDevice::getConfigMessage(GraphCfg graphData) {
     json.addKeyFloat(F("widthRatio"), graphData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), graphData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), graphData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(graphData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(graphData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
     json.addKeyString(F("xAxisLabel"), graphData.xAxisLabel);
-    json.addKeyFloat(F("xAxisMin"), graphData.xAxisMin);
-    json.addKeyFloat(F("xAxisMax"), graphData.xAxisMax);
-    json.addKeyInt(F("xAxisNumBars"), graphData.xAxisNumBars);
-    json.addKeyString(F("xAxisLabelsStyle"), getXAxisLabelsStyleStr(graphData.xAxisLabelsStyle));
+    json.addOptionalFloat(F("xAxisMin"), graphData.xAxisMin, defaults.xAxisMin);
+    json.addOptionalFloat(F("xAxisMax"), graphData.xAxisMax, defaults.xAxisMax);
+    json.addOptionalInt(F("xAxisNumBars"), graphData.xAxisNumBars, defaults.xAxisNumBars);
+    json.addOptionalString(F("xAxisLabelsStyle"), getXAxisLabelsStyleStr(graphData.xAxisLabelsStyle), getXAxisLabelsStyleStr(defaults.xAxisLabelsStyle));
     json.addKeyString(F("yAxisLabel"), graphData.yAxisLabel);
-    json.addKeyFloat(F("yAxisMin"), graphData.yAxisMin);
-    json.addKeyFloat(F("yAxisMax"), graphData.yAxisMax);
-    json.addKeyInt(F("yAxisNumBars"), graphData.yAxisNumBars, true);
-    return getFullConfigMessage(graph, json.jsonStr);
+    json.addOptionalFloat(F("yAxisMin"), graphData.yAxisMin, defaults.yAxisMin);
+    json.addOptionalFloat(F("yAxisMax"), graphData.yAxisMax, defaults.yAxisMax);
+    json.addOptionalInt(F("yAxisNumBars"), graphData.yAxisNumBars, defaults.yAxisNumBars, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(TimeGraphCfg timeGraphData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const TimeGraphDesc& timeGraphData) {
+    writeFullConfigHeader(writer, timeGraph);
+    const TimeGraphDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), timeGraphData.controlID);
     json.addKeyString(F("parentID"), timeGraphData.parentID);
@@ -1290,17 +2386,20 @@ String DashioDevice::getConfigMessage(TimeGraphCfg timeGraphData) {
     json.addKeyFloat(F("widthRatio"), timeGraphData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), timeGraphData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), timeGraphData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(timeGraphData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(timeGraphData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
     json.addKeyString(F("yAxisLabel"), timeGraphData.yAxisLabel);
-    json.addKeyFloat(F("yAxisMin"), timeGraphData.yAxisMin);
-    json.addKeyFloat(F("yAxisMax"), timeGraphData.yAxisMax);
-    json.addKeyInt(F("yAxisNumBars"), timeGraphData.yAxisNumBars, true);
-    return getFullConfigMessage(timeGraph, json.jsonStr);
+    json.addOptionalFloat(F("yAxisMin"), timeGraphData.yAxisMin, defaults.yAxisMin);
+    json.addOptionalFloat(F("yAxisMax"), timeGraphData.yAxisMax, defaults.yAxisMax);
+    json.addOptionalInt(F("yAxisNumBars"), timeGraphData.yAxisNumBars, defaults.yAxisNumBars, true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(MapCfg mapData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const MapDesc& mapData) {
+    writeFullConfigHeader(writer, mapper);
+    const MapDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), mapData.controlID);
     json.addKeyString(F("parentID"), mapData.parentID);
@@ -1309,12 +2408,15 @@ String DashioDevice::getConfigMessage(MapCfg mapData) {
     json.addKeyFloat(F("widthRatio"), mapData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), mapData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), mapData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(mapData.titlePosition), true);
-    return getFullConfigMessage(mapper, json.jsonStr);
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(mapData.titlePosition), getTitlePositionStr(defaults.titlePosition), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(ColorCfg colorData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const ColorDesc& colorData) {
+    writeFullConfigHeader(writer, colorPicker);
+    const ColorDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), colorData.controlID);
     json.addKeyString(F("parentID"), colorData.parentID);
@@ -1323,15 +2425,18 @@ String DashioDevice::getConfigMessage(ColorCfg colorData) {
     json.addKeyFloat(F("widthRatio"), colorData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), colorData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), colorData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(colorData.titlePosition));
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(colorData.titlePosition), getTitlePositionStr(defaults.titlePosition));
 
-    json.addKeyBool(F("sendOnlyOnRelease"), colorData.sendOnlyOnRelease);
-    json.addKeyString(F("pickerStyle"), getColorStyleStr(colorData.pickerStyle), true);
-    return getFullConfigMessage(colorPicker, json.jsonStr);
+    json.addOptionalBool(F("sendOnlyOnRelease"), colorData.sendOnlyOnRelease, defaults.sendOnlyOnRelease);
+    json.addOptionalString(F("pickerStyle"), getColorStyleStr(colorData.pickerStyle), getColorStyleStr(defaults.pickerStyle), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getConfigMessage(AudioVisualCfg avData) {
-    DashJSON json;
+bool DashioDevice::writeConfigMessage(MessageWriter& writer, const AudioVisualDesc& avData) {
+    writeFullConfigHeader(writer, audioVisual);
+    const AudioVisualDesc defaults("", "", "");
+    DashJSON json(writer);
+    json.omitDefaults = omitConfigDefaults;
     json.start();
     json.addKeyString(F("controlID"), avData.controlID);
     json.addKeyString(F("parentID"), avData.parentID);
@@ -1340,46 +2445,114 @@ String DashioDevice::getConfigMessage(AudioVisualCfg avData) {
     json.addKeyFloat(F("widthRatio"), avData.graphicsRect.widthRatio);
     json.addKeyFloat(F("heightRatio"), avData.graphicsRect.heightRatio);
     json.addKeyString(F("title"), avData.title);
-    json.addKeyString(F("titlePosition"), getTitlePositionStr(avData.titlePosition), true);
-    return getFullConfigMessage(audioVisual, json.jsonStr);
+    json.addOptionalString(F("titlePosition"), getTitlePositionStr(avData.titlePosition), getTitlePositionStr(defaults.titlePosition), true);
+    return endMessage(writer);
 }
 
-String DashioDevice::getWaypointJSON(Waypoint waypoint) {
-    DashJSON json;
+void DashioDevice::writeWaypointJSON(MessageWriter& writer, const Waypoint& waypoint) {
+    DashJSON json(writer);
     json.start();
     if (waypoint.time.length() > 0) {
-        json.addKeyString(F("time"), waypoint.time);
+        json.addKeyString(F("time"), waypoint.time.c_str());
     }
     if (waypoint.avgeSpeed.length() > 0) {
-        json.addKeyString(F("avgeSpeed"), waypoint.avgeSpeed);
+        json.addKeyString(F("avgeSpeed"), waypoint.avgeSpeed.c_str());
     }
     if (waypoint.peakSpeed.length() > 0) {
-        json.addKeyString(F("peakSpeed"), waypoint.peakSpeed);
+        json.addKeyString(F("peakSpeed"), waypoint.peakSpeed.c_str());
     }
     if (waypoint.course.length() > 0) {
-        json.addKeyString(F("course"), waypoint.course);
+        json.addKeyString(F("course"), waypoint.course.c_str());
     }
     if (waypoint.altitude.length() > 0) {
-        json.addKeyString(F("altitude"), waypoint.altitude);
+        json.addKeyString(F("altitude"), waypoint.altitude.c_str());
     }
     if (waypoint.distance.length() > 0) {
-        json.addKeyString(F("distance"), waypoint.distance);
+        json.addKeyString(F("distance"), waypoint.distance.c_str());
+    }
+    json.addKeyString(F("latitude"), waypoint.latitude.c_str());
+    json.addKeyString(F("longitude"), waypoint.longitude.c_str(), true);
+}
+
+void DashioDevice::writeEventJSON(MessageWriter& writer, const Event& event) {
+    DashJSON json(writer);
+    json.start();
+    json.addKeyString(F("time"), event.time.c_str());
+    json.addKeyString(F("color"), event.color.c_str());
+    json.addKeyStringArray(F("lines"), event.lines, event.numLines, true);
+}
+
+// Track point values are sent as strings, the same as the String Waypoint fields
+static void addTrackValue(DashJSON& json, const __FlashStringHelper *key, long value, uint8_t decimals, bool last = false) {
+    char numberBuffer[FORMAT_BUFFER_SIZE];
+    formatScaledInt(numberBuffer, value, decimals);
+    json.addKeyString(key, numberBuffer, last);
+}
+
+// Seconds since 1970 to yyyy-MM-ddTHH:mm:ssZ, using the days to civil date algorithm from
+// http://howardhinnant.github.io/date_algorithms.html
+static void formatTrackTime(char *buffer, uint32_t time) {
+    uint32_t days = time / 86400;
+    uint32_t seconds = time % 86400;
+    uint32_t z = days + 719468;
+    uint32_t era = z / 146097;
+    uint32_t dayOfEra = z - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t mp = (5 * dayOfYear + 2) / 153;
+    uint32_t day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+    uint32_t fields[] = {year, month, day, seconds / 3600, (seconds / 60) % 60, seconds % 60};
+    const char separators[] = "--T::Z";
+    size_t len = 0;
+    for (int i = 0; i < 6; i++) {
+        if (fields[i] < 10) {
+            buffer[len++] = '0';
+        }
+        len += formatInt(buffer + len, fields[i]);
+        buffer[len++] = separators[i];
+    }
+    buffer[len] = '\0';
+}
+
+void DashioDevice::writeTrackPointJSON(MessageWriter& writer, const TrackPoint& waypoint) {
+    DashJSON json(writer);
+    json.start();
+    if (waypoint.time != TRACK_NO_TIME) {
+        char timeBuffer[FORMAT_BUFFER_SIZE];
+        formatTrackTime(timeBuffer, waypoint.time);
+        json.addKeyString(F("time"), timeBuffer);
+    }
+    if (waypoint.avgeSpeed != TRACK_NO_SPEED) {
+        addTrackValue(json, F("avgeSpeed"), waypoint.avgeSpeed, 2);
+    }
+    if (waypoint.peakSpeed != TRACK_NO_SPEED) {
+        addTrackValue(json, F("peakSpeed"), waypoint.peakSpeed, 2);
+    }
+    if (waypoint.course != TRACK_NO_COURSE) {
+        addTrackValue(json, F("course"), waypoint.course, 1);
+    }
+    if (waypoint.altitude != TRACK_NO_ALTITUDE) {
+        addTrackValue(json, F("altitude"), waypoint.altitude, 2);
+    }
+    if (waypoint.distance != TRACK_NO_DISTANCE) {
+        addTrackValue(json, F("distance"), waypoint.distance, 2);
     }
-    json.addKeyString(F("latitude"), waypoint.latitude);
-    json.addKeyString(F("longitude"), waypoint.longitude, true);
-    return json.jsonStr;
+    addTrackValue(json, F("latitude"), waypoint.latitude, TRACK_DEGREES_DECIMALS);
+    addTrackValue(json, F("longitude"), waypoint.longitude, TRACK_DEGREES_DECIMALS, true);
 }
 
-String DashioDevice::getEventJSON(Event event) {
-    DashJSON json;
+void DashioDevice::writeEventEntryJSON(MessageWriter& writer, const EventEntry& event) {
+    DashJSON json(writer);
     json.start();
     json.addKeyString(F("time"), event.time);
     json.addKeyString(F("color"), event.color);
     json.addKeyStringArray(F("lines"), event.lines, event.numLines, true);
-    return json.jsonStr;
 }
 
-String DashioDevice::getTitlePositionStr(TitlePosition tbp) {
+const char * DashioDevice::getTitlePositionStr(TitlePosition tbp) {
     switch (tbp) {
         case titleTop:
             return "TOP";
@@ -1390,7 +2563,7 @@ String DashioDevice::getTitlePositionStr(TitlePosition tbp) {
     }
 }
 
-String DashioDevice::getLabelStyle(LabelStyle labelStyle) {
+const char * DashioDevice::getLabelStyle(LabelStyle labelStyle) {
     switch (labelStyle) {
         case basic:
             return "BASIC";
@@ -1401,7 +2574,7 @@ String DashioDevice::getLabelStyle(LabelStyle labelStyle) {
     }
 }
 
-String DashioDevice::getDialNumberPosition(DialNumberPosition numberPosition) {
+const char * DashioDevice::getDialNumberPosition(DialNumberPosition numberPosition) {
     switch (numberPosition) {
         case numberLeft:
             return "LEFT";
@@ -1414,7 +2587,7 @@ String DashioDevice::getDialNumberPosition(DialNumberPosition numberPosition) {
     }
 }
 
-String DashioDevice::getKnobPresentationStyle(KnobPresentationStyle presentationStyle) {
+const char * DashioDevice::getKnobPresentationStyle(KnobPresentationStyle presentationStyle) {
     switch (presentationStyle) {
         case knobPan:
             return "PAN";
@@ -1423,7 +2596,7 @@ String DashioDevice::getKnobPresentationStyle(KnobPresentationStyle presentation
     }
 }
 
-String DashioDevice::getDialPresentationStyle(DialPresentationStyle presentationStyle) {
+const char * DashioDevice::getDialPresentationStyle(DialPresentationStyle presentationStyle) {
     switch (presentationStyle) {
         case dialPie:
             return "PIE";
@@ -1434,7 +2607,7 @@ String DashioDevice::getDialPresentationStyle(DialPresentationStyle presentation
     }
 }
 
-String DashioDevice::getDirectionPresentationStyle(DirectionPresentationStyle presentationStyle) {
+const char * DashioDevice::getDirectionPresentationStyle(DirectionPresentationStyle presentationStyle) {
     switch (presentationStyle) {
         case dirDeg:
             return "DEG";
@@ -1445,7 +2618,7 @@ String DashioDevice::getDirectionPresentationStyle(DirectionPresentationStyle pr
     }
 }
 
-String DashioDevice::getTextFormatStr(TextFormat format) {
+const char * DashioDevice::getTextFormatStr(TextFormat format) {
     switch (format) {
         case numFmt:
             return "NUM";
@@ -1460,7 +2633,7 @@ String DashioDevice::getTextFormatStr(TextFormat format) {
     }
 }
 
-String DashioDevice::getKeyboardTypeStr(KeyboardType kbd) {
+const char * DashioDevice::getKeyboardTypeStr(KeyboardType kbd) {
     switch (kbd) {
         case hexKbd:
             return "HEX";
@@ -1483,7 +2656,7 @@ String DashioDevice::getKeyboardTypeStr(KeyboardType kbd) {
     }
 }
 
-String DashioDevice::getTextAlignStr(TextAlign align) {
+const char * DashioDevice::getTextAlignStr(TextAlign align) {
     switch (align) {
         case textLeft:
             return "LEFT";
@@ -1494,7 +2667,7 @@ String DashioDevice::getTextAlignStr(TextAlign align) {
     }
 }
 
-String DashioDevice::getBarStyleStr(BarStyle barStyle) {
+const char * DashioDevice::getBarStyleStr(BarStyle barStyle) {
     switch (barStyle) {
         case segmentedBar:
             return "SEG";
@@ -1503,7 +2676,7 @@ String DashioDevice::getBarStyleStr(BarStyle barStyle) {
     }
 }
 
-String DashioDevice::getXAxisLabelsStyleStr(XAxisLabelsStyle xls) {
+const char * DashioDevice::getXAxisLabelsStyleStr(XAxisLabelsStyle xls) {
     switch (xls) {
         case labelsOnLines:
             return "ON";
@@ -1512,7 +2685,7 @@ String DashioDevice::getXAxisLabelsStyleStr(XAxisLabelsStyle xls) {
     }
 }
 
-String DashioDevice::getColorStyleStr(ColorPickerStyle pickerStyle) {
+const char * DashioDevice::getColorStyleStr(ColorPickerStyle pickerStyle) {
     switch (pickerStyle) {
         case spectrum:
             return "SPEC";
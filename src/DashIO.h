@@ -31,6 +31,7 @@
 
 #include "Arduino.h"
 #include <limits.h>
+#include "DashWriter.h"
 
 extern char DASH_SERVER[];
 #define DASH_PORT 8883
@@ -39,6 +40,10 @@ extern char DASH_SERVER[];
 #define INVALID_FLOAT_VALUE 0xFFFFFFFF
 #define INVALID_INT_VALUE INT_MAX
 
+#define MAX_STRING_LEN 64
+#define MAX_DEVICE_HEADER_LEN (MAX_STRING_LEN + 3) // "\t<deviceID>\t" and the null
+#define CONFIG_HASH_LEN 8
+
 enum ConnectionType {
     TCP_CONN,
     BLE_CONN,
@@ -210,6 +215,34 @@ struct Event {
     int numLines;                 // Number of lines of text
 };
 
+// Values that leave a TrackPoint field out of the message
+#define TRACK_NO_TIME     0
+#define TRACK_NO_ALTITUDE INT32_MIN
+#define TRACK_NO_DISTANCE UINT32_MAX
+#define TRACK_NO_SPEED    UINT16_MAX
+#define TRACK_NO_COURSE   INT16_MIN
+
+// Compact fixed point waypoint (28 bytes), so that tracks of thousands of points can be kept on the device.
+// Each value is formatted straight from the integer, so there is no float rounding and no String.
+struct TrackPoint {
+    uint32_t time = TRACK_NO_TIME; // Seconds since 1970-01-01 UTC. Sent as yyyy-MM-dd’T’HH:mm:ssZ (refer to ISO 8601)
+    int32_t  latitude = 0;        // Latitude in millionths of a degree
+    int32_t  longitude = 0;       // Longitude in millionths of a degree
+    int32_t  altitude = TRACK_NO_ALTITUDE; // Altitude in centimeters
+    uint32_t distance = TRACK_NO_DISTANCE; // Accumulated distance since the last message in centimeters
+    uint16_t avgeSpeed = TRACK_NO_SPEED; // Average speed since the last message in centimeters/second
+    uint16_t peakSpeed = TRACK_NO_SPEED; // Maximum speed since the last message in centimeters/second
+    int16_t  course = TRACK_NO_COURSE; // Course direction in tenths of a degree. A negative value indicates an unknown heading
+};
+
+// Event for event logs that are streamed from application storage
+struct EventEntry {
+    const char *time = "";        // yyyy-MM-dd’T’HH:mm:ssZ (refer to ISO 8601)
+    const char *color = "";       // Color name from colors in IoT Dashboard e.g. "blue" or index
+    const char * const *lines = NULL; // Lines of text
+    int numLines = 0;             // Number of lines of text
+};
+
 struct BLEConnCfg {
     String serviceUUID;           // BLE Service UUID
     String readUUID;              // BLE read characteristic UUID
@@ -468,10 +501,312 @@ struct AudioVisualCfg : CommonControl {
              : CommonControl(_controlID, _parentID, _title, _graphicsRect) {}
 };
 
+// Compact descriptors for writeConfigMessage. They have the same fields and defaults as the Cfg structs, but hold
+// text as pointers, so describing a control uses no heap. The text isn't copied, so it must outlive the descriptor,
+// e.g. string literals. A descriptor made from a Cfg struct points into that struct's Strings.
+// The constructors are constexpr, so descriptors can also be compiled into a config table (see ConfigTableEntry).
+struct CommonControlDesc {
+    const char *controlID;
+    const char *parentID;
+    const char *title;
+    TitlePosition titlePosition = titleTop;
+    Rect   graphicsRect;
+
+    constexpr CommonControlDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect)
+                                : controlID(_controlID), parentID(_parentID), title(_title), graphicsRect(_graphicsRect) {}
+    explicit CommonControlDesc(const CommonControl& cfg);
+};
+
+struct DeviceDesc {
+    int    numDeviceViews;
+    const char *deviceSetup;
+
+    constexpr DeviceDesc(int _numDeviceViews, const char *_deviceSetup = "")
+                         : numDeviceViews(_numDeviceViews), deviceSetup(_deviceSetup) {}
+    explicit DeviceDesc(const DeviceCfg& cfg);
+};
+
+struct DeviceViewDesc {
+    const char *controlID;
+    const char *title;
+    const char *iconName;
+    const char *color = "black";
+    bool shareColumn = true;
+    int numColumns = 1;
+    int ctrlMaxFontSize = 30;
+    bool ctrlBorderOn = true;
+    const char *ctrlBorderColor = "white";
+    const char *ctrlColor = "white";
+    const char *ctrlBkgndColor = "blue";
+    int ctrlBkgndTransparency = 0;
+    int ctrlTitleFontSize = 18;
+    const char *ctrlTitleBoxColor = "blue";
+    int ctrlTitleBoxTransparency = 0;
+
+    constexpr DeviceViewDesc(const char *_controlID, const char *_title, const char *_iconName, const char *_color)
+                             : controlID(_controlID), title(_title), iconName(_iconName), color(_color) {}
+    explicit DeviceViewDesc(const DeviceViewCfg& cfg);
+};
+
+struct AlarmDesc {
+    const char *controlID;
+    const char *description;
+    const char *soundName = "Default";
+
+    constexpr AlarmDesc(const char *_controlID, const char *_description, const char *_soundName = "Default")
+                        : controlID(_controlID), description(_description), soundName(_soundName) {}
+    explicit AlarmDesc(const AlarmCfg& cfg);
+};
+
+struct LabelDesc : CommonControlDesc {
+    LabelStyle style = group;
+    const char *color = "white";
+
+    constexpr LabelDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                        : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit LabelDesc(const LabelCfg& cfg);
+};
+
+struct ButtonDesc : CommonControlDesc {
+    bool buttonEnabled = true;
+    const char *iconName = "";
+    const char *text = "";
+    const char *offColor = "dark gray";
+    const char *onColor = "white";
+
+    constexpr ButtonDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                         : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit ButtonDesc(const ButtonCfg& cfg);
+};
+
+struct MenuDesc : CommonControlDesc {
+    const char *iconName = "menu";
+    const char *text = "";
+
+    constexpr MenuDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                       : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit MenuDesc(const MenuCfg& cfg);
+};
+
+struct ButtonGroupDesc : CommonControlDesc {
+    const char *iconName = "group";
+    const char *text = "";
+    bool gridView = true;
+
+    constexpr ButtonGroupDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                              : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit ButtonGroupDesc(const ButtonGroupCfg& cfg);
+};
+
+struct EventLogDesc : CommonControlDesc {
+    constexpr EventLogDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                           : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit EventLogDesc(const EventLogCfg& cfg);
+};
+
+struct KnobDesc : CommonControlDesc {
+    float min = 0;
+    float max = 100;
+    float redValue = 70;
+    bool showMinMax = true;
+    KnobPresentationStyle style = knobNormal;
+    const char *knobColor = "red";
+    bool sendOnlyOnRelease = true;
+    bool dialFollowsKnob = true;
+    const char *dialColor = "yellow";
+
+    constexpr KnobDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                       : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit KnobDesc(const KnobCfg& cfg);
+};
+
+struct DialDesc : CommonControlDesc {
+    float min = 0;
+    float max = 100;
+    float redValue = 70;
+    const char *dialFillColor = "green";
+    const char *pointerColor = "yellow";
+    DialNumberPosition numberPosition = numberCenter;
+    bool showMinMax = true;
+    DialPresentationStyle style = dialBar;
+    const char *units = "";
+    int precision = 3;
+
+    constexpr DialDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                       : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit DialDesc(const DialCfg& cfg);
+};
+
+struct DirectionDesc : CommonControlDesc {
+    const char *pointerColor = "yellow";
+    DirectionPresentationStyle style = dirNSEW;
+    int calAngle = 0;
+    const char *units = "";
+    int precision = 3;
+
+    constexpr DirectionDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                            : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit DirectionDesc(const DirectionCfg& cfg);
+};
+
+struct TextBoxDesc : CommonControlDesc {
+    TextFormat format = noFmt;
+    TextAlign textAlign = textCenter;
+    const char *units = "";
+    int precision = 0;
+    KeyboardType kbdType = allKbd;
+    bool closeKbdOnSend = true;
+
+    constexpr TextBoxDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                          : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit TextBoxDesc(const TextBoxCfg& cfg);
+};
+
+struct SelectorDesc : CommonControlDesc {
+    constexpr SelectorDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                           : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit SelectorDesc(const SelectorCfg& cfg);
+};
+
+struct SliderDesc : CommonControlDesc {
+    float min = 0;
+    float max = 100;
+    float redValue = 70;
+    bool showMinMax = true;
+    bool sliderEnabled = true;
+    const char *knobColor = "white";
+    bool sendOnlyOnRelease = true;
+    bool barFollowsSlider = true;
+    const char *barColor = "green";
+    BarStyle barStyle = segmentedBar;
+
+    constexpr SliderDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                         : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit SliderDesc(const SliderCfg& cfg);
+};
+
+struct GraphDesc : CommonControlDesc {
+    const char *xAxisLabel = "";
+    float xAxisMin = 0;
+    float xAxisMax = 100;
+    int xAxisNumBars = 6;
+    XAxisLabelsStyle xAxisLabelsStyle = labelsOnLines;
+    const char *yAxisLabel = "";
+    float yAxisMin = 0;
+    float yAxisMax = 100;
+    int yAxisNumBars = 6;
+
+    constexpr GraphDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                        : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit GraphDesc(const GraphCfg& cfg);
+};
+
+struct TimeGraphDesc : CommonControlDesc {
+    const char *yAxisLabel = "";
+    float yAxisMin = 0;
+    float yAxisMax = 100;
+    int yAxisNumBars = 6;
+
+    constexpr TimeGraphDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                            : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit TimeGraphDesc(const TimeGraphCfg& cfg);
+};
+
+struct MapDesc : CommonControlDesc {
+    constexpr MapDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                      : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit MapDesc(const MapCfg& cfg);
+};
+
+struct ColorDesc : CommonControlDesc {
+    ColorPickerStyle pickerStyle = wheel;
+    bool sendOnlyOnRelease = true;
+
+    constexpr ColorDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                        : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit ColorDesc(const ColorCfg& cfg);
+};
+
+struct AudioVisualDesc : CommonControlDesc {
+    constexpr AudioVisualDesc(const char *_controlID, const char *_parentID, const char *_title, Rect _graphicsRect = Rect())
+                              : CommonControlDesc(_controlID, _parentID, _title, _graphicsRect) {}
+    explicit AudioVisualDesc(const AudioVisualCfg& cfg);
+};
+
+// Entry in a config table for setConfigTable(). Fully static dashboards can be compiled into flash, e.g.
+//     constexpr KnobDesc speedKnob PROGMEM = KnobDesc("KB01", "DV01", "Speed", {0, 0, 1, 0.5});
+//     const ConfigTableEntry configTable[] PROGMEM = {configEntry(deviceDesc), configEntry(viewDesc), configEntry(speedKnob)};
+// Descriptors are read with memcpy_P, so on AVR and ESP8266 they and the table must be PROGMEM. Their text is read from RAM.
+// Fields that aren't constructor parameters can be set in a constexpr function that returns the descriptor (C++14).
+struct ConfigTableEntry {
+    ControlType controlType;
+    const void *desc;
+
+    constexpr ConfigTableEntry(ControlType _controlType, const void *_desc) : controlType(_controlType), desc(_desc) {}
+};
+
+constexpr ConfigTableEntry configEntry(const DeviceDesc& desc) { return ConfigTableEntry(device, &desc); }
+constexpr ConfigTableEntry configEntry(const DeviceViewDesc& desc) { return ConfigTableEntry(deviceView, &desc); }
+constexpr ConfigTableEntry configEntry(const AlarmDesc& desc) { return ConfigTableEntry(alarmNotify, &desc); }
+constexpr ConfigTableEntry configEntry(const LabelDesc& desc) { return ConfigTableEntry(label, &desc); }
+constexpr ConfigTableEntry configEntry(const ButtonDesc& desc) { return ConfigTableEntry(button, &desc); }
+constexpr ConfigTableEntry configEntry(const MenuDesc& desc) { return ConfigTableEntry(menu, &desc); }
+constexpr ConfigTableEntry configEntry(const ButtonGroupDesc& desc) { return ConfigTableEntry(buttonGroup, &desc); }
+constexpr ConfigTableEntry configEntry(const EventLogDesc& desc) { return ConfigTableEntry(eventLog, &desc); }
+constexpr ConfigTableEntry configEntry(const KnobDesc& desc) { return ConfigTableEntry(knob, &desc); }
+constexpr ConfigTableEntry configEntry(const DialDesc& desc) { return ConfigTableEntry(dial, &desc); }
+constexpr ConfigTableEntry configEntry(const DirectionDesc& desc) { return ConfigTableEntry(direction, &desc); }
+constexpr ConfigTableEntry configEntry(const TextBoxDesc& desc) { return ConfigTableEntry(textBox, &desc); }
+constexpr ConfigTableEntry configEntry(const SelectorDesc& desc) { return ConfigTableEntry(selector, &desc); }
+constexpr ConfigTableEntry configEntry(const SliderDesc& desc) { return ConfigTableEntry(slider, &desc); }
+constexpr ConfigTableEntry configEntry(const GraphDesc& desc) { return ConfigTableEntry(graph, &desc); }
+constexpr ConfigTableEntry configEntry(const TimeGraphDesc& desc) { return ConfigTableEntry(timeGraph, &desc); }
+constexpr ConfigTableEntry configEntry(const MapDesc& desc) { return ConfigTableEntry(mapper, &desc); }
+constexpr ConfigTableEntry configEntry(const ColorDesc& desc) { return ConfigTableEntry(colorPicker, &desc); }
+constexpr ConfigTableEntry configEntry(const AudioVisualDesc& desc) { return ConfigTableEntry(audioVisual, &desc); }
+
+#ifndef MESSAGE_BUFFER_LEN
+#ifdef ARDUINO_ARCH_AVR
+#define MESSAGE_BUFFER_LEN 128
+#else
+#define MESSAGE_BUFFER_LEN 256
+#endif
+#endif
+
+// Number of received messages that a QueuedMessageData can hold until they are read with nextMessage(). Must be a
+// power of 2. AVR boards only use processChar, so have no QueuedMessageData.
+#ifndef MESSAGE_QUEUE_DEPTH
+#ifdef ARDUINO_ARCH_AVR
+#define MESSAGE_QUEUE_DEPTH 0
+#else
+#define MESSAGE_QUEUE_DEPTH 4
+#endif
+#endif
+
+#if MESSAGE_QUEUE_DEPTH > 0
+#include <atomic>
+#endif
+
+#define MESSAGE_FIELDS 4 // deviceID, id, payload and payload2
+
+// Non-owning view of part of a received message. The text is null terminated.
+struct TextSpan {
+    const char *text = "";
+    size_t length = 0;
+
+    TextSpan() {}
+    TextSpan(const char *_text, size_t _length) : text(_text), length(_length) {}
+    bool equals(const char *str) const;
+    String toString() const;
+};
+
+// Control type for a received ID, or unknown if the ID isn't one that is received by a device
+ControlType getControlTypeFromID(const char *idStr, size_t idLength);
+
 class MessageData {
 public:
     ConnectionType connectionType;
-    bool messageReceived = false;
+    unsigned int droppedMessages = 0; // Messages lost because the previous one hadn't been read, or the queue was full
     String deviceID = ((char *)0);
 
     ControlType control = unknown;
@@ -483,16 +818,82 @@ public:
     String payloadStr4 = ((char *)0);
 */
 
+    // The same fields as above, as views into the message buffer. Valid until the next message starts.
+    TextSpan deviceIDSpan;
+    TextSpan idSpan;
+    TextSpan payloadSpan;
+    TextSpan payloadSpan2;
+    bool stringFields = true; // Set to false to only use the spans and skip copying into the String fields
+
     MessageData(ConnectionType connType);
+
+    // Parses every complete message in the data, to be read with nextMessage(). Only one message is held, so use a
+    // QueuedMessageData where one receive can carry several messages.
     void processMessage(const String& message);
+    virtual void processMessage(const char *message, size_t messageLength);
+
+    // Makes the next message from processMessage the current message. Returns false when there are none left.
+    virtual bool nextMessage();
+
+    // True while there are messages from processMessage that nextMessage() hasn't read yet
+    virtual bool messageReceived();
+
+    // Returns true when chr completes a message, which is then the current message
     bool processChar(char chr);
+
+    // Discards a partly received message, e.g. when a new client takes over the connection
+    void reset();
+
     String getReceivedMessageForPrint(const String& controlStr);
 
+protected:
+    ControlType readControl = unknown;
+    TextSpan readFields[MESSAGE_FIELDS];
+
+    bool parseChar(char chr);
+    void setCurrentMessage(ControlType _control, const TextSpan fields[]);
+
 private:
     int segmentCount = -1;
-    String readStr;
+    char buffer[MESSAGE_BUFFER_LEN];
+    uint16_t readStart = 0;
+    uint16_t readLength = 0;
+    bool messageWaiting = false;
+
+    TextSpan endSegment();
 };
 
+#if MESSAGE_QUEUE_DEPTH > 0
+// A MessageData that holds up to MESSAGE_QUEUE_DEPTH messages from processMessage, for MQTT and BLE where one
+// receive can carry several messages. TCP reads with processChar, so doesn't need the queue's RAM.
+class QueuedMessageData : public MessageData {
+public:
+    QueuedMessageData(ConnectionType connType) : MessageData(connType) {}
+
+    using MessageData::processMessage;
+    void processMessage(const char *message, size_t messageLength) override;
+    bool nextMessage() override;
+    bool messageReceived() override;
+
+private:
+    struct QueuedMessage {
+        ControlType control;
+        uint16_t fieldLengths[MESSAGE_FIELDS];
+        char text[MESSAGE_BUFFER_LEN];
+    };
+
+    // Single producer, single consumer ring, so a receive callback can add messages while run() reads them.
+    // On the ESP32 the BLE callback runs on the other core, so each side publishes its index with release
+    // ordering, and reads the other side's with acquire, so that a slot is never read before it is written.
+    QueuedMessage queue[MESSAGE_QUEUE_DEPTH];
+    std::atomic<uint8_t> queueHead{0}; // Only written by nextMessage()
+    std::atomic<uint8_t> queueTail{0}; // Only written by queueMessage()
+    bool queueHeadInUse = false;
+
+    void queueMessage();
+};
+#endif
+
 class DashioDevice {
 public:
     String mqttSubscrberTopic;
@@ -506,6 +907,7 @@ public:
     void setup(const String& deviceIdentifier, const String& _deviceName);
     void setup(uint8_t m_address[6]);
     void setup(uint8_t m_address[6], const String& _deviceName);
+    const String& getDeviceID();
 
     String getWhoMessage();
     String getConnectMessage();
@@ -540,6 +942,8 @@ public:
     String getDirectionMessage(const String& controlID, float direction, float speed = -1);
     String getMapWaypointMessage(const String& controlID, const String& trackID, const String& latitude, const String& longitude);
     String getMapTrackMessage(const String& controlID, const String& trackID, const String& text, const String& colour, Waypoint waypoints[] = {}, int numWaypoints = 0);
+    String getMapWaypointMessage(const String& controlID, const String& trackID, const TrackPoint& waypoint);
+    String getMapTrackMessage(const String& controlID, const String& trackID, const String& text, const String& colour, const TrackPoint waypoints[], int numWaypoints);
     String getEventLogMessage(const String& controlID, const String& timeStr, const String& color, String text[], int numTextRows);
     String getEventLogMessage(const String& controlID, Event events[], int numEvents);
     String getColorMessage(const String& controlID, const String& color);
@@ -559,31 +963,58 @@ public:
     String getBasicConfigMessage(const String& configData);
     String getFullConfigMessage(ControlType controlType, const String& configData);
 
-    String getConfigMessage(DeviceCfg deviceConfigData);
-    String getConfigMessage(DeviceViewCfg deviceViewData);
-
-    String getConfigMessage(BLEConnCfg MessageData);
-    String getConfigMessage(TCPConnCfg MessageData);
-    String getConfigMessage(MQTTConnCfg MessageData);
-
-    String getConfigMessage(AlarmCfg alarmData);
-
-    String getConfigMessage(LabelCfg labelData);
-    String getConfigMessage(ButtonCfg buttonData);
-    String getConfigMessage(MenuCfg menuData);
-    String getConfigMessage(ButtonGroupCfg groupData);
-    String getConfigMessage(EventLogCfg eventLogData);
-    String getConfigMessage(KnobCfg knobData);
-    String getConfigMessage(DialCfg dialData);
-    String getConfigMessage(DirectionCfg directionData);
-    String getConfigMessage(TextBoxCfg textBoxData);
-    String getConfigMessage(SelectorCfg selectorData);
-    String getConfigMessage(SliderCfg sliderData);
-    String getConfigMessage(GraphCfg graphData);
-    String getConfigMessage(TimeGraphCfg timeGraphData);
-    String getConfigMessage(MapCfg mapData);
-    String getConfigMessage(ColorCfg colorData);
-    String getConfigMessage(AudioVisualCfg avData);
+    String getConfigMessage(const DeviceCfg& deviceConfigData);
+    String getConfigMessage(const DeviceViewCfg& deviceViewData);
+
+    String getConfigMessage(const BLEConnCfg& connectionData);
+    String getConfigMessage(const TCPConnCfg& connectionData);
+    String getConfigMessage(const MQTTConnCfg& connectionData);
+
+    String getConfigMessage(const AlarmCfg& alarmData);
+
+    String getConfigMessage(const LabelCfg& labelData);
+    String getConfigMessage(const ButtonCfg& buttonData);
+    String getConfigMessage(const MenuCfg& menuData);
+    String getConfigMessage(const ButtonGroupCfg& groupData);
+    String getConfigMessage(const EventLogCfg& eventLogData);
+    String getConfigMessage(const KnobCfg& knobData);
+    String getConfigMessage(const DialCfg& dialData);
+    String getConfigMessage(const DirectionCfg& directionData);
+    String getConfigMessage(const TextBoxCfg& textBoxData);
+    String getConfigMessage(const SelectorCfg& selectorData);
+    String getConfigMessage(const SliderCfg& sliderData);
+    String getConfigMessage(const GraphCfg& graphData);
+    String getConfigMessage(const TimeGraphCfg& timeGraphData);
+    String getConfigMessage(const MapCfg& mapData);
+    String getConfigMessage(const ColorCfg& colorData);
+    String getConfigMessage(const AudioVisualCfg& avData);
+
+//  Config snapshot. The config table entries are written first, then the builder writes any other config messages,
+//  e.g. with writeConfigMessage(). Either may be used alone. The snapshot is written for BROADCAST_ID and is only rebuilt
+//  after setConfigChanged(). The builder is called more than once per rebuild (to measure, write and hash the config),
+//  so it should only write. Connections with a snapshot reply to CFG from it instead of calling their message callback.
+//  writeConfigPage writes the page of whole messages starting at pageStart that fits in maxPageLength (at least one
+//  message, however long), with the requesting dashboard's ID in place of BROADCAST_ID. It returns the length of the
+//  snapshot it used, or 0 when there are no more pages. Connections send one page per run(). getConfigReply is the
+//  whole config for one dashboard.
+//  With a snapshot, WHO and CONNECT replies end with a hash of the config. A dashboard that sends that hash as the
+//  CFG payload gets the short config unchanged reply instead of the whole config.
+//  Connections pass every received message to handleConfigRequest. It returns true for a CFG request that the snapshot
+//  answers, with reply set to the config unchanged message or the whole config, to send instead of calling the message
+//  callback. A connection that sends pages passes pagedReply, and gets an empty reply when it should start the pages.
+//  Otherwise it returns false, and for a CFG request sets dashboardID for the callback's config messages.
+    void setConfigBuilder(void (*_configBuilder)(MessageWriter& writer));
+    void setConfigTable(const ConfigTableEntry *_configTable, size_t _configTableLength);
+    bool hasConfigSnapshot();
+    void setConfigChanged();
+    void setOmitConfigDefaults(bool omit); // Leave out config fields that equal the Cfg struct defaults, for shorter config
+    const String& getConfigSnapshot();
+    size_t writeConfigPage(MessageWriter& writer, size_t pageStart, size_t maxPageLength, const char *clientDashboardID);
+    String getConfigReply(const String& clientDashboardID);
+    uint32_t getConfigHash();
+    bool isConfigUnchanged(const String& clientConfigHash);
+    String getConfigUnchangedMessage(const String& clientDashboardID);
+    bool handleConfigRequest(const MessageData& data, String& reply, bool pagedReply = false);
 
     String getOnlineMessage();
     String getOfflineMessage();
@@ -592,28 +1023,168 @@ public:
 
     String getMQTTSubscribeTopic(const String& userName);
     String getMQTTTopic(const String& userName, MQTTTopicType topic);
+
+//  Messages written into a caller supplied MessageWriter. Each returns false if the writer overflowed.
+    bool writeWhoMessage(MessageWriter& writer);
+    bool writeConnectMessage(MessageWriter& writer);
+    bool writeConfigUnchangedMessage(MessageWriter& writer, const char *clientDashboardID);
+
+    bool writeDeviceNameMessage(MessageWriter& writer);
+    bool writeWifiUpdateAckMessage(MessageWriter& writer);
+    bool writeTCPUpdateAckMessage(MessageWriter& writer);
+    bool writeDashioUpdateAckMessage(MessageWriter& writer);
+    bool writeMQTTUpdateAckMessage(MessageWriter& writer);
+
+    bool writeAlarmMessage(MessageWriter& writer, const char *alarmID, const char *title, const char *description);
+    bool writeButtonMessage(MessageWriter& writer, const char *controlID, bool on, const char *iconName = "", const char *text = "");
+    bool writeTextBoxMessage(MessageWriter& writer, const char *controlID, const char *text);
+    bool writeSelectorMessage(MessageWriter& writer, const char *controlID, int index);
+    bool writeSelectorMessage(MessageWriter& writer, const char *controlID, int index, const String selectionItems[], int numItems);
+
+    bool writeSliderMessage(MessageWriter& writer, const char *controlID, int value);
+    bool writeSliderMessage(MessageWriter& writer, const char *controlID, float value);
+    bool writeSingleBarMessage(MessageWriter& writer, const char *controlID, int value);
+    bool writeSingleBarMessage(MessageWriter& writer, const char *controlID, float value);
+    bool writeDoubleBarMessage(MessageWriter& writer, const char *controlID, int value1, int value2);
+    bool writeDoubleBarMessage(MessageWriter& writer, const char *controlID, float value1, float value2);
+
+    bool writeKnobMessage(MessageWriter& writer, const char *controlID, int value);
+    bool writeKnobMessage(MessageWriter& writer, const char *controlID, float value);
+    bool writeKnobDialMessage(MessageWriter& writer, const char *controlID, int value);
+    bool writeKnobDialMessage(MessageWriter& writer, const char *controlID, float value);
+    bool writeDialMessage(MessageWriter& writer, const char *controlID, int value);
+    bool writeDialMessage(MessageWriter& writer, const char *controlID, float value);
+    bool writeDirectionMessage(MessageWriter& writer, const char *controlID, int direction, float speed = -1);
+    bool writeDirectionMessage(MessageWriter& writer, const char *controlID, float direction, float speed = -1);
+    bool writeMapWaypointMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *latitude, const char *longitude);
+    bool writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, const Waypoint waypoints[] = {}, int numWaypoints = 0);
+    bool writeMapWaypointMessage(MessageWriter& writer, const char *controlID, const char *trackID, const TrackPoint& waypoint);
+    bool writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, const TrackPoint waypoints[], int numWaypoints);
+    bool writeEventLogMessage(MessageWriter& writer, const char *controlID, const char *timeStr, const char *color, const String text[], int numTextRows);
+    bool writeEventLogMessage(MessageWriter& writer, const char *controlID, const Event events[], int numEvents);
+
+//  Streamed tracks and event logs. The callback fills in the item at index, and returns false when there are no more.
+//  Every write starts again from index 0, so the same callback can be used to measure and then write. With a sink
+//  writer (e.g. a WiFiClient) the message goes straight to the transport, so any number of items needs no heap.
+    bool writeMapTrackMessage(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour, bool (*getWaypoint)(int index, TrackPoint& waypoint));
+    bool writeEventLogMessage(MessageWriter& writer, const char *controlID, bool (*getEvent)(int index, EventEntry& event));
+    bool writeColorMessage(MessageWriter& writer, const char *controlID, const char *color);
+    bool writeAudioVisualMessage(MessageWriter& writer, const char *controlID, const char *url = "");
+
+    bool writeGraphLineInts(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const int lineData[], int dataLength);
+    bool writeGraphLineFloats(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const float lineData[], int dataLength);
+    bool writeTimeGraphLineFloats(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const String times[], const float lineData[], int dataLength, bool breakLine = false);
+    bool writeTimeGraphLineBools(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color, const String times[], const bool lineData[], int dataLength);
+    bool writeTimeGraphPoint(MessageWriter& writer, const char *controlID, const char *graphLineID, float value);
+    bool writeTimeGraphPoint(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *time, float value);
+    bool writeTimeGraphLine(MessageWriter& writer, const char *controlID, const char *graphLineID, const char *lineName, LineType lineType, const char *color);
+
+    bool writeBasicConfigData(MessageWriter& writer, ControlType controlType, const char *controlID, const char *controlTitle);
+    bool writeBasicConfigMessage(MessageWriter& writer, ControlType controlType, const char *controlID, const char *controlTitle);
+
+    bool writeConfigMessage(MessageWriter& writer, const DeviceCfg& deviceConfigData);
+    bool writeConfigMessage(MessageWriter& writer, const DeviceDesc& deviceConfigData);
+    bool writeConfigMessage(MessageWriter& writer, const DeviceViewCfg& deviceViewData);
+    bool writeConfigMessage(MessageWriter& writer, const DeviceViewDesc& deviceViewData);
+
+    bool writeConfigMessage(MessageWriter& writer, const BLEConnCfg& connectionData);
+    bool writeConfigMessage(MessageWriter& writer, const TCPConnCfg& connectionData);
+    bool writeConfigMessage(MessageWriter& writer, const MQTTConnCfg& connectionData);
+
+    bool writeConfigMessage(MessageWriter& writer, const AlarmCfg& alarmData);
+    bool writeConfigMessage(MessageWriter& writer, const AlarmDesc& alarmData);
+
+    bool writeConfigMessage(MessageWriter& writer, const LabelCfg& labelData);
+    bool writeConfigMessage(MessageWriter& writer, const ButtonCfg& buttonData);
+    bool writeConfigMessage(MessageWriter& writer, const MenuCfg& menuData);
+    bool writeConfigMessage(MessageWriter& writer, const ButtonGroupCfg& groupData);
+    bool writeConfigMessage(MessageWriter& writer, const EventLogCfg& eventLogData);
+    bool writeConfigMessage(MessageWriter& writer, const KnobCfg& knobData);
+    bool writeConfigMessage(MessageWriter& writer, const DialCfg& dialData);
+    bool writeConfigMessage(MessageWriter& writer, const DirectionCfg& directionData);
+    bool writeConfigMessage(MessageWriter& writer, const TextBoxCfg& textBoxData);
+    bool writeConfigMessage(MessageWriter& writer, const SelectorCfg& selectorData);
+    bool writeConfigMessage(MessageWriter& writer, const SliderCfg& sliderData);
+    bool writeConfigMessage(MessageWriter& writer, const GraphCfg& graphData);
+    bool writeConfigMessage(MessageWriter& writer, const TimeGraphCfg& timeGraphData);
+    bool writeConfigMessage(MessageWriter& writer, const MapCfg& mapData);
+    bool writeConfigMessage(MessageWriter& writer, const ColorCfg& colorData);
+    bool writeConfigMessage(MessageWriter& writer, const AudioVisualCfg& avData);
+
+    bool writeConfigMessage(MessageWriter& writer, const LabelDesc& labelData);
+    bool writeConfigMessage(MessageWriter& writer, const ButtonDesc& buttonData);
+    bool writeConfigMessage(MessageWriter& writer, const MenuDesc& menuData);
+    bool writeConfigMessage(MessageWriter& writer, const ButtonGroupDesc& groupData);
+    bool writeConfigMessage(MessageWriter& writer, const EventLogDesc& eventLogData);
+    bool writeConfigMessage(MessageWriter& writer, const KnobDesc& knobData);
+    bool writeConfigMessage(MessageWriter& writer, const DialDesc& dialData);
+    bool writeConfigMessage(MessageWriter& writer, const DirectionDesc& directionData);
+    bool writeConfigMessage(MessageWriter& writer, const TextBoxDesc& textBoxData);
+    bool writeConfigMessage(MessageWriter& writer, const SelectorDesc& selectorData);
+    bool writeConfigMessage(MessageWriter& writer, const SliderDesc& sliderData);
+    bool writeConfigMessage(MessageWriter& writer, const GraphDesc& graphData);
+    bool writeConfigMessage(MessageWriter& writer, const TimeGraphDesc& timeGraphData);
+    bool writeConfigMessage(MessageWriter& writer, const MapDesc& mapData);
+    bool writeConfigMessage(MessageWriter& writer, const ColorDesc& colorData);
+    bool writeConfigMessage(MessageWriter& writer, const AudioVisualDesc& avData);
+
+    bool writeOnlineMessage(MessageWriter& writer);
+    bool writeOfflineMessage(MessageWriter& writer);
+    
     
 private:
-    String getControlBaseMessage(const String& messageType, const String& controlID);
-    String getLineTypeStr(LineType lineType);
-    String getIntArray(const String& controlType, const String& ID, int idata[], int dataLength);
-    String getFloatArray(const String& controlType, const String& ID, float fdata[], int dataLength);
-
-    String getWaypointJSON(Waypoint waypoint);
-    String getEventJSON(Event event);
-
-    String getTitlePositionStr(TitlePosition tbp);
-    String getLabelStyle(LabelStyle labelStyle);
-    String getKnobPresentationStyle(KnobPresentationStyle presentationStyle);
-    String getDialNumberPosition(DialNumberPosition numberPosition);
-    String getDialPresentationStyle(DialPresentationStyle presentationStyle);
-    String getDirectionPresentationStyle(DirectionPresentationStyle presentationStyle);
-    String getTextFormatStr(TextFormat format);
-    String getKeyboardTypeStr(KeyboardType kbd);
-    String getTextAlignStr(TextAlign align);
-    String getBarStyleStr(BarStyle barStyle);
-    String getXAxisLabelsStyleStr(XAxisLabelsStyle xls);
-    String getColorStyleStr(ColorPickerStyle pickerStyle);
+#ifndef ARDUINO_ARCH_AVR // Not worth the RAM on AVR, where the header is written from deviceID each time
+    char deviceHeader[MAX_DEVICE_HEADER_LEN];
+    uint8_t deviceHeaderLength = 0;
+#endif
+
+    void (*configBuilder)(MessageWriter& writer) = NULL;
+    const ConfigTableEntry *configTable = NULL;
+    size_t configTableLength = 0;
+    String configSnapshot = ((char *)0);
+    bool writingBroadcastConfig = false; // Config headers get BROADCAST_ID instead of dashboardID
+    bool configChanged = true;
+    uint32_t configHash = 0;
+    bool configHashValid = false;
+    bool omitConfigDefaults = false;
+
+    bool isDeviceHeaderCurrent();
+    void updateDeviceHeader();
+    void writeDeviceHeader(MessageWriter& writer);
+    void writeDeviceMessage(MessageWriter& writer, const char *messageType);
+    void writeControlBaseMessage(MessageWriter& writer, const char *controlType, const char *controlID);
+    void writeFullConfigHeader(MessageWriter& writer, ControlType controlType);
+    bool endMessage(MessageWriter& writer);
+    void writeConfigHash(MessageWriter& writer);
+    void writeConfig(MessageWriter& writer);
+    bool writeConfigTableEntry(MessageWriter& writer, const ConfigTableEntry& entry);
+    template <typename Desc> bool writeConfigDesc(MessageWriter& writer, const void *desc);
+    template <typename WriteMessage> String getShortMessage(size_t textLength, WriteMessage writeMessage);
+    template <typename WriteMessage> String getMeasuredMessage(WriteMessage writeMessage);
+    const char * getConfigHashStr(char *hashStr);
+    bool writeIntArray(MessageWriter& writer, const char *controlType, const char *ID, const int idata[], int dataLength);
+    bool writeFloatArray(MessageWriter& writer, const char *controlType, const char *ID, const float fdata[], int dataLength);
+
+    void writeWaypointJSON(MessageWriter& writer, const Waypoint& waypoint);
+    void writeEventJSON(MessageWriter& writer, const Event& event);
+    void writeMapTrackHeader(MessageWriter& writer, const char *controlID, const char *trackID, const char *text, const char *colour);
+    void writeTrackPointJSON(MessageWriter& writer, const TrackPoint& waypoint);
+    void writeEventEntryJSON(MessageWriter& writer, const EventEntry& event);
+
+    const char * getControlTypeID(ControlType controltype);
+    const char * getLineTypeStr(LineType lineType);
+    const char * getTitlePositionStr(TitlePosition tbp);
+    const char * getLabelStyle(LabelStyle labelStyle);
+    const char * getKnobPresentationStyle(KnobPresentationStyle presentationStyle);
+    const char * getDialNumberPosition(DialNumberPosition numberPosition);
+    const char * getDialPresentationStyle(DialPresentationStyle presentationStyle);
+    const char * getDirectionPresentationStyle(DirectionPresentationStyle presentationStyle);
+    const char * getTextFormatStr(TextFormat format);
+    const char * getKeyboardTypeStr(KeyboardType kbd);
+    const char * getTextAlignStr(TextAlign align);
+    const char * getBarStyleStr(BarStyle barStyle);
+    const char * getXAxisLabelsStyleStr(XAxisLabelsStyle xls);
+    const char * getColorStyleStr(ColorPickerStyle pickerStyle);
 };
 
 #endif
@@ -28,81 +28,199 @@
 
 #include "DashJSON.h"
 
+#define JSON_FLOAT_PRECISION 3
+
+DashJSON::DashJSON() : stringWriter(jsonStr) {
+    writer = &stringWriter;
+}
+
+DashJSON::DashJSON(MessageWriter& _writer) : stringWriter(jsonStr) {
+    writer = &_writer;
+}
+
 void DashJSON::start() {
-    jsonStr = "{";
+    if (writer == &stringWriter) {
+        stringWriter.reset();
+    }
+    writer->add('{');
+    firstKey = true;
 }
 
 void DashJSON::addKeyString(const String& key, const String& text, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":\"";
-    jsonStr += text;
-    jsonStr += "\"";
+    addKey(key);
+    addString(text.c_str());
+    nextChar(last);
+}
+
+void DashJSON::addKeyString(const __FlashStringHelper *key, const char *text, bool last) {
+    addKey(key);
+    addString(text);
     nextChar(last);
 }
 
 void DashJSON::addKeyStringAsNumber(const String& key, const String& text, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":";
-    jsonStr += text;
+    addKey(key);
+    writer->add(text);
     nextChar(last);
 }
 
-void DashJSON::addKeyStringArray(const String& key, String items[], int numItems, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":[";
-    for (int i = 0; i < numItems; i++) {
-        jsonStr += "\"";
-        jsonStr += items[i];
-        jsonStr += "\"";
-        if (i < numItems - 1) {
-            jsonStr += ",";
-        }
-    }
-    jsonStr += "]";
+void DashJSON::addKeyStringAsNumber(const __FlashStringHelper *key, const char *text, bool last) {
+    addKey(key);
+    writer->add(text);
+    nextChar(last);
+}
+
+void DashJSON::addKeyStringArray(const String& key, const String items[], int numItems, bool last) {
+    addKey(key);
+    addStringArray(items, numItems);
+    nextChar(last);
+}
+
+void DashJSON::addKeyStringArray(const __FlashStringHelper *key, const String items[], int numItems, bool last) {
+    addKey(key);
+    addStringArray(items, numItems);
+    nextChar(last);
+}
+
+void DashJSON::addKeyStringArray(const __FlashStringHelper *key, const char * const items[], int numItems, bool last) {
+    addKey(key);
+    addStringArray(items, numItems);
     nextChar(last);
 }
 
 void DashJSON::addKeyFloat(const String& key, float number, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":";
-    char numberBuffer[9];
-#ifdef ARDUINO_ARCH_AVR
-    dtostrf(number, 5, 3, numberBuffer);
-#else
-    sprintf(numberBuffer, "%5.3f", number);
-#endif
-    jsonStr += numberBuffer;
+    addKey(key);
+    addFloat(number);
+    nextChar(last);
+}
+
+void DashJSON::addKeyFloat(const __FlashStringHelper *key, float number, bool last) {
+    addKey(key);
+    addFloat(number);
     nextChar(last);
 }
 
 void DashJSON::addKeyInt(const String& key, int number, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":";
-    jsonStr += String(number);
+    addKey(key);
+    writer->addInt(number);
+    nextChar(last);
+}
+
+void DashJSON::addKeyInt(const __FlashStringHelper *key, int number, bool last) {
+    addKey(key);
+    writer->addInt(number);
     nextChar(last);
 }
 
 void DashJSON::addKeyBool(const String& key, bool boolean, bool last) {
-    jsonStr += "\"";
-    jsonStr += key;
-    jsonStr += "\":";
+    addKey(key);
+    addBool(boolean);
+    nextChar(last);
+}
+
+void DashJSON::addKeyBool(const __FlashStringHelper *key, bool boolean, bool last) {
+    addKey(key);
+    addBool(boolean);
+    nextChar(last);
+}
+
+void DashJSON::addOptionalString(const __FlashStringHelper *key, const char *text, const char *defaultText, bool last) {
+    if (omitDefaults && (strcmp(text, defaultText) == 0)) {
+        nextChar(last);
+    } else {
+        addKeyString(key, text, last);
+    }
+}
+
+void DashJSON::addOptionalFloat(const __FlashStringHelper *key, float number, float defaultNumber, bool last) {
+    if (omitDefaults && (number == defaultNumber)) {
+        nextChar(last);
+    } else {
+        addKeyFloat(key, number, last);
+    }
+}
+
+void DashJSON::addOptionalInt(const __FlashStringHelper *key, int number, int defaultNumber, bool last) {
+    if (omitDefaults && (number == defaultNumber)) {
+        nextChar(last);
+    } else {
+        addKeyInt(key, number, last);
+    }
+}
+
+void DashJSON::addOptionalBool(const __FlashStringHelper *key, bool boolean, bool defaultBoolean, bool last) {
+    if (omitDefaults && (boolean == defaultBoolean)) {
+        nextChar(last);
+    } else {
+        addKeyBool(key, boolean, last);
+    }
+}
+
+// The separator goes before each key, so that the object can end after a value that was left out
+void DashJSON::addKey(const String& key) {
+    if (!firstKey) {
+        writer->add(',');
+    }
+    firstKey = false;
+    writer->add('"');
+    writer->add(key);
+    writer->add("\":");
+}
+
+void DashJSON::addKey(const __FlashStringHelper *key) {
+    if (!firstKey) {
+        writer->add(',');
+    }
+    firstKey = false;
+    writer->add('"');
+    writer->add(key);
+    writer->add("\":");
+}
+
+void DashJSON::addString(const char *text) {
+    writer->add('"');
+    writer->add(text);
+    writer->add('"');
+}
+
+void DashJSON::addFloat(float number) {
+    char numberBuffer[FORMAT_BUFFER_SIZE];
+    formatFloat(numberBuffer, number, JSON_FLOAT_PRECISION, true);
+    writer->add(numberBuffer);
+}
+
+void DashJSON::addBool(bool boolean) {
     if (boolean) {
-        jsonStr += "true";
+        writer->add("true");
     } else {
-        jsonStr += "false";
+        writer->add("false");
     }
-    nextChar(last);
+}
+
+void DashJSON::addStringArray(const String items[], int numItems) {
+    writer->add('[');
+    for (int i = 0; i < numItems; i++) {
+        addString(items[i].c_str());
+        if (i < numItems - 1) {
+            writer->add(',');
+        }
+    }
+    writer->add(']');
+}
+
+void DashJSON::addStringArray(const char * const items[], int numItems) {
+    writer->add('[');
+    for (int i = 0; i < numItems; i++) {
+        addString(items[i]);
+        if (i < numItems - 1) {
+            writer->add(',');
+        }
+    }
+    writer->add(']');
 }
 
 void DashJSON::nextChar(bool last) {
     if (last) {
-        jsonStr += "}";
-    } else {
-        jsonStr += ",";
+        writer->add('}');
     }
 }
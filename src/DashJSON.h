@@ -30,20 +30,49 @@
 #define DashJSON_h
 
 #include "Arduino.h"
+#include "DashWriter.h"
 
 class DashJSON {
 public:
     String jsonStr = "";
+    bool omitDefaults = false; // When true, the addOptional methods leave out values that equal their default
+
+    DashJSON();
+    DashJSON(MessageWriter& _writer); // Write directly into the writer instead of jsonStr
+    DashJSON(const DashJSON&) = delete; // The writer points into this object, so it can't be copied
+    DashJSON& operator=(const DashJSON&) = delete;
 
     void start();
     void addKeyString(const String& key, const String& text, bool last = false);
+    void addKeyString(const __FlashStringHelper *key, const char *text, bool last = false);
     void addKeyFloat(const String& key, float number, bool last = false);
+    void addKeyFloat(const __FlashStringHelper *key, float number, bool last = false);
     void addKeyInt(const String& key, int number, bool last = false);
+    void addKeyInt(const __FlashStringHelper *key, int number, bool last = false);
     void addKeyBool(const String& key, bool boolean, bool last = false);
+    void addKeyBool(const __FlashStringHelper *key, bool boolean, bool last = false);
     void addKeyStringAsNumber(const String& key, const String& text, bool last = false);
-    void addKeyStringArray(const String& key, String items[], int numItems, bool last = false);
+    void addKeyStringAsNumber(const __FlashStringHelper *key, const char *text, bool last = false);
+    void addKeyStringArray(const String& key, const String items[], int numItems, bool last = false);
+    void addKeyStringArray(const __FlashStringHelper *key, const String items[], int numItems, bool last = false);
+    void addKeyStringArray(const __FlashStringHelper *key, const char * const items[], int numItems, bool last = false);
+    void addOptionalString(const __FlashStringHelper *key, const char *text, const char *defaultText, bool last = false);
+    void addOptionalFloat(const __FlashStringHelper *key, float number, float defaultNumber, bool last = false);
+    void addOptionalInt(const __FlashStringHelper *key, int number, int defaultNumber, bool last = false);
+    void addOptionalBool(const __FlashStringHelper *key, bool boolean, bool defaultBoolean, bool last = false);
 
 private:
+    MessageWriter stringWriter;
+    MessageWriter *writer;
+    bool firstKey = true;
+
+    void addKey(const String& key);
+    void addKey(const __FlashStringHelper *key);
+    void addString(const char *text);
+    void addFloat(float number);
+    void addBool(bool boolean);
+    void addStringArray(const String items[], int numItems);
+    void addStringArray(const char * const items[], int numItems);
     void nextChar(bool last);
 };
 
@@ -0,0 +1,482 @@
+/*
+ DashWriter.cpp - Library for fixed capacity message writing for the DashIO comms protocol.
+
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include "DashWriter.h"
+#include "DashIO.h"
+
+// Used instead of fixed point for numbers that don't fit in a uint32_t once scaled by the precision
+#define MAX_FIXED_POINT_VALUE 4.0e9
+
+static const uint32_t powersOfTen[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+// unsigned long, so the full range of a long is written on hosts where it is 64 bits
+static size_t formatUnsigned(char *buffer, unsigned long value, uint8_t minDigits = 1) {
+    char digits[20];
+    uint8_t numDigits = 0;
+    do {
+        digits[numDigits++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (numDigits < minDigits) {
+        digits[numDigits++] = '0';
+    }
+    for (uint8_t i = 0; i < numDigits; i++) {
+        buffer[i] = digits[numDigits - 1 - i];
+    }
+    return numDigits;
+}
+
+// Scaling is done as a double because a float can't hold all the digits of the rounded result
+static size_t formatFixedPoint(char *buffer, float value, uint8_t precision) {
+    uint32_t scaled = (uint32_t)((double)value * powersOfTen[precision] + 0.5);
+    size_t len = formatUnsigned(buffer, scaled / powersOfTen[precision]);
+    if (precision > 0) {
+        buffer[len++] = '.';
+        len += formatUnsigned(buffer + len, scaled % powersOfTen[precision], precision);
+    }
+    return len;
+}
+
+static size_t formatExponent(char *buffer, float value, uint8_t precision) {
+    int exponent = 0;
+    while (value >= 1.0e8f) {
+        value /= 1.0e8f;
+        exponent += 8;
+    }
+    while (value >= 10.0f) {
+        value /= 10.0f;
+        exponent++;
+    }
+    while (value < 1.0e-7f) {
+        value *= 1.0e8f;
+        exponent -= 8;
+    }
+    while (value < 1.0f) {
+        value *= 10.0f;
+        exponent--;
+    }
+
+    uint32_t scaled = (uint32_t)((double)value * powersOfTen[precision] + 0.5);
+    if (scaled >= powersOfTen[precision + 1]) { // Rounded up to 10.0
+        scaled /= 10;
+        exponent++;
+    }
+
+    size_t len = formatUnsigned(buffer, scaled / powersOfTen[precision]);
+    if (precision > 0) {
+        buffer[len++] = '.';
+        len += formatUnsigned(buffer + len, scaled % powersOfTen[precision], precision);
+    }
+    buffer[len++] = 'e';
+    if (exponent < 0) {
+        buffer[len++] = '-';
+        exponent = -exponent;
+    } else {
+        buffer[len++] = '+';
+    }
+    len += formatUnsigned(buffer + len, exponent, 2);
+    return len;
+}
+
+size_t formatInt(char *buffer, long value) {
+    size_t len = 0;
+    unsigned long magnitude = value;
+    if (value < 0) {
+        buffer[len++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    len += formatUnsigned(buffer + len, magnitude);
+    buffer[len] = '\0';
+    return len;
+}
+
+size_t formatScaledInt(char *buffer, long value, uint8_t decimals) {
+    size_t len = 0;
+    unsigned long magnitude = value;
+    if (value < 0) {
+        buffer[len++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    len += formatUnsigned(buffer + len, magnitude / powersOfTen[decimals]);
+    if (decimals > 0) {
+        buffer[len++] = '.';
+        len += formatUnsigned(buffer + len, magnitude % powersOfTen[decimals], decimals);
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+size_t formatFloat(char *buffer, float value, uint8_t precision, bool fixedPoint) {
+    size_t len = 0;
+    if (isnan(value)) {
+        strcpy(buffer, "nan");
+        return 3;
+    }
+    if (value < 0) {
+        buffer[len++] = '-';
+        value = -value;
+    }
+    if (isinf(value)) {
+        strcpy(buffer + len, "inf");
+        return len + 3;
+    }
+    if (precision > MAX_FLOAT_PRECISION) {
+        precision = MAX_FLOAT_PRECISION;
+    }
+
+    if (value == 0) {
+        len += formatFixedPoint(buffer + len, value, precision);
+    } else if (value * powersOfTen[precision] >= MAX_FIXED_POINT_VALUE) {
+        len += formatExponent(buffer + len, value, precision);
+    } else if (!fixedPoint && ((value < 1.0f) || (value >= 100000))) {
+        len += formatExponent(buffer + len, value, precision);
+    } else {
+        len += formatFixedPoint(buffer + len, value, precision);
+    }
+    buffer[len] = '\0';
+    return len;
+}
+
+MessageWriter::MessageWriter() {
+    measureOnly = true;
+    reset();
+}
+
+MessageWriter::MessageWriter(char *_buffer, size_t _bufferSize) {
+    buffer = _buffer;
+    bufferSize = _bufferSize;
+    reset();
+}
+
+MessageWriter::MessageWriter(char *_buffer, size_t _bufferSize, Print& _sink) {
+    buffer = _buffer;
+    bufferSize = _bufferSize;
+    sink = &_sink;
+    reset();
+}
+
+MessageWriter::MessageWriter(String& _str) {
+    str = &_str;
+    reset();
+}
+
+MessageWriter::~MessageWriter() {
+    flush();
+}
+
+void MessageWriter::reset() {
+    len = 0;
+    flushedLength = 0;
+    overflowed = false;
+    if (str != NULL) {
+        *str = "";
+    } else if (bufferSize > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+void MessageWriter::flush() {
+    if ((sink != NULL) && (len > 0)) {
+        writeToSink(buffer, len);
+        len = 0;
+        buffer[0] = '\0';
+    }
+}
+
+void MessageWriter::writeToSink(const char *text, size_t textLength) {
+    if (sink->write((const uint8_t *)text, textLength) != textLength) {
+        overflowed = true;
+    }
+    flushedLength += textLength;
+}
+
+// Returns true if textLength chars fit in the buffer, after flushing it to the sink if there is one
+bool MessageWriter::makeRoom(size_t textLength) {
+    if (len + textLength < bufferSize) { // Leave room for the terminating null
+        return true;
+    }
+    if (sink == NULL) {
+        overflowed = true;
+        return false;
+    }
+    flush();
+    return textLength < bufferSize;
+}
+
+void MessageWriter::add(char chr) {
+    if (overflowed) {
+        return;
+    }
+    if (str != NULL) {
+        if (!str->concat(chr)) {
+            overflowed = true;
+            return;
+        }
+    } else if (!measureOnly) {
+        if (!makeRoom(1)) {
+            overflowed = true;
+            return;
+        }
+        buffer[len] = chr;
+        buffer[len + 1] = '\0';
+    }
+    len++;
+}
+
+void MessageWriter::add(const char *text) {
+    if ((str != NULL) && !overflowed) {
+        if (!str->concat(text)) {
+            overflowed = true;
+            return;
+        }
+        len = str->length();
+        return;
+    }
+    add(text, strlen(text));
+}
+
+void MessageWriter::add(const char *text, size_t textLength) {
+    if (overflowed) {
+        return;
+    }
+    if (str != NULL) {
+        for (size_t i = 0; i < textLength; i++) {
+            if (!str->concat(text[i])) {
+                overflowed = true;
+                return;
+            }
+        }
+    } else if (!measureOnly) {
+        if (!makeRoom(textLength)) {
+            if (sink != NULL) { // Too long for the buffer, so straight to the sink
+                writeToSink(text, textLength);
+            }
+            return;
+        }
+        memcpy(buffer + len, text, textLength);
+        buffer[len + textLength] = '\0';
+    }
+    len += textLength;
+}
+
+void MessageWriter::add(const String& text) {
+    add(text.c_str(), text.length());
+}
+
+void MessageWriter::add(const __FlashStringHelper *text) {
+    if (overflowed) {
+        return;
+    }
+    PGM_P p = reinterpret_cast<PGM_P>(text);
+    size_t textLength = strlen_P(p);
+    if (str != NULL) {
+        if (!str->concat(text)) {
+            overflowed = true;
+            return;
+        }
+    } else if (!measureOnly) {
+        if (!makeRoom(textLength)) {
+            if (sink != NULL) {
+                if (sink->print(text) != textLength) {
+                    overflowed = true;
+                }
+                flushedLength += textLength;
+            }
+            return;
+        }
+        memcpy_P(buffer + len, p, textLength);
+        buffer[len + textLength] = '\0';
+    }
+    len += textLength;
+}
+
+void MessageWriter::addInt(int value) {
+    if (value == INVALID_INT_VALUE) {
+        add("nan");
+        return;
+    }
+
+    char numberBuffer[FORMAT_BUFFER_SIZE];
+    formatInt(numberBuffer, value);
+    add(numberBuffer);
+}
+
+void MessageWriter::addFloat(float value) {
+    if (value == INVALID_FLOAT_VALUE) {
+        add("nan");
+        return;
+    } else if (abs(value) < SMALLEST_FLOAT_VALUE) {
+        add('0');
+        return;
+    }
+
+    char numberBuffer[FORMAT_BUFFER_SIZE];
+    formatFloat(numberBuffer, value, precision);
+    add(numberBuffer);
+}
+
+void MessageWriter::setPrecision(uint8_t _precision) {
+    precision = _precision;
+}
+
+const char * MessageWriter::c_str() {
+    if (str != NULL) {
+        return str->c_str();
+    }
+    if (bufferSize == 0) {
+        return "";
+    }
+    return buffer;
+}
+
+size_t MessageWriter::length() {
+    return flushedLength + len;
+}
+
+size_t MessageWriter::capacity() {
+    if ((str != NULL) || (sink != NULL) || measureOnly) {
+        return SIZE_MAX;
+    }
+    return bufferSize > 0 ? bufferSize - 1 : 0;
+}
+
+bool MessageWriter::overflow() {
+    return overflowed;
+}
+
+MessageBatch::MessageBatch(char *_buffer, size_t _bufferSize, void (*_flushCallback)(const char *messages, size_t length), unsigned long _flushDeadline) {
+    buffer = _buffer;
+    bufferSize = _bufferSize;
+    flushCallback = _flushCallback;
+    flushDeadline = _flushDeadline;
+}
+
+void MessageBatch::add(const String& message) {
+    add(message.c_str(), message.length());
+}
+
+void MessageBatch::add(const char *message, size_t messageLength) {
+    if (messageLength == 0) {
+        return;
+    }
+    if (len + messageLength >= bufferSize) { // Leave room for the terminating null
+        flush();
+        if (messageLength >= bufferSize) {
+            flushCallback(message, messageLength);
+            return;
+        }
+    }
+
+    if (len == 0) {
+        firstMessageTime = millis();
+    }
+    memcpy(buffer + len, message, messageLength);
+    len += messageLength;
+    buffer[len] = '\0';
+}
+
+void MessageBatch::run() {
+    if ((len > 0) && (millis() - firstMessageTime >= flushDeadline)) {
+        flush();
+    }
+}
+
+void MessageBatch::flush() {
+    if (len > 0) {
+        flushCallback(buffer, len);
+        len = 0;
+        buffer[0] = '\0';
+    }
+}
+
+bool MessageBatch::isEmpty() {
+    return len == 0;
+}
+
+SendQueue::SendQueue(char *_buffer, size_t _bufferSize) {
+    buffer = _buffer;
+    bufferSize = _bufferSize;
+}
+
+bool SendQueue::add(const char *data, size_t dataLength) {
+    if (dataLength > bufferSize - len) {
+        return false;
+    }
+
+    size_t tail = (head + len) % bufferSize;
+    size_t firstPart = min(dataLength, bufferSize - tail);
+    memcpy(buffer + tail, data, firstPart);
+    memcpy(buffer, data + firstPart, dataLength - firstPart); // Wraps around to the start of the buffer
+    len += dataLength;
+    return true;
+}
+
+size_t SendQueue::write(uint8_t chr) {
+    return add((const char *)&chr, 1) ? 1 : 0;
+}
+
+size_t SendQueue::write(const uint8_t *data, size_t dataLength) {
+    return add((const char *)data, dataLength) ? dataLength : 0;
+}
+
+size_t SendQueue::peek(const char **data) {
+    *data = buffer + head;
+    return min(len, bufferSize - head);
+}
+
+void SendQueue::remove(size_t dataLength) {
+    if (dataLength >= len) {
+        clear();
+        return;
+    }
+    head = (head + dataLength) % bufferSize;
+    len -= dataLength;
+}
+
+// Starting again at the front keeps the next message contiguous
+void SendQueue::clear() {
+    head = 0;
+    len = 0;
+}
+
+size_t SendQueue::length() {
+    return len;
+}
+
+size_t SendQueue::space() {
+    return bufferSize - len;
+}
+
+size_t SendQueue::capacity() {
+    return bufferSize;
+}
+
+bool SendQueue::isEmpty() {
+    return len == 0;
+}
@@ -0,0 +1,142 @@
+/*
+ DashWriter.h - Library for fixed capacity message writing for the DashIO comms protocol.
+
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#ifndef DashWriter_h
+#define DashWriter_h
+
+#include "Arduino.h"
+
+#define FORMAT_BUFFER_SIZE 24  // Large enough for any formatInt or formatFloat result
+#define DEFAULT_FLOAT_PRECISION 2
+#define MAX_FLOAT_PRECISION 6
+#define DEFAULT_BATCH_FLUSH_MS 20
+
+// Number to text without printf or the heap. Both return the number of characters written, excluding the null.
+// formatFloat writes precision decimal places. Values that are too large for fixed point (or, unless fixedPoint is
+// set, smaller than 1 or 100000 and over) are written in exponent form, e.g. 1.23e+06.
+size_t formatInt(char *buffer, long value);
+size_t formatScaledInt(char *buffer, long value, uint8_t decimals); // e.g. value 1234567 with 6 decimals is 1.234567
+size_t formatFloat(char *buffer, float value, uint8_t precision = DEFAULT_FLOAT_PRECISION, bool fixedPoint = false);
+
+// Writes messages into a caller supplied buffer (stack, static or transport buffer) without using the heap.
+// If the buffer is too small, the writer stops accepting data and overflow() returns true.
+// The String constructor is used by the String returning DashioDevice methods.
+// With a sink (e.g. a WiFiClient or EthernetClient), the buffer is only a working buffer. It is written to the
+// sink whenever it fills, on flush() and when the writer is destroyed, so messages of any length can be written.
+// Without a buffer, the writer only measures: length() is the exact size of what was written, e.g. to reserve a
+// String once or to check that a message fits a transport buffer before writing it.
+class MessageWriter {
+public:
+    MessageWriter();
+    MessageWriter(char *_buffer, size_t _bufferSize);
+    MessageWriter(char *_buffer, size_t _bufferSize, Print& _sink);
+    MessageWriter(String& _str);
+    MessageWriter(const MessageWriter&) = delete; // A copy would share the buffer, and flush it again when destroyed
+    MessageWriter& operator=(const MessageWriter&) = delete;
+    ~MessageWriter();
+
+    void reset();
+    void flush();
+
+    void add(char chr);
+    void add(const char *text);
+    void add(const char *text, size_t textLength);
+    void add(const String& text);
+    void add(const __FlashStringHelper *text);
+    void addInt(int value);
+    void addFloat(float value);
+    void setPrecision(uint8_t _precision); // Decimal places used by addFloat
+
+    const char * c_str(); // With a sink, only the text that hasn't been flushed yet
+    size_t length();
+    size_t capacity();
+    bool overflow();
+
+private:
+    char *buffer = NULL;
+    size_t bufferSize = 0;
+    String *str = NULL;
+    Print *sink = NULL;
+    size_t len = 0;
+    size_t flushedLength = 0;
+    bool overflowed = false;
+    bool measureOnly = false;
+    uint8_t precision = DEFAULT_FLOAT_PRECISION;
+
+    bool makeRoom(size_t textLength);
+    void writeToSink(const char *text, size_t textLength);
+};
+
+// Collects outgoing messages in a caller supplied buffer, so that they go out in one write per connection.
+// The flush callback is called from run() once the oldest message has waited flushDeadline ms, when a message
+// doesn't fit, or from flush(). Messages larger than the buffer are passed straight to the callback.
+class MessageBatch {
+public:
+    MessageBatch(char *_buffer, size_t _bufferSize, void (*_flushCallback)(const char *messages, size_t length), unsigned long _flushDeadline = DEFAULT_BATCH_FLUSH_MS);
+
+    void add(const String& message);
+    void add(const char *message, size_t messageLength);
+    void run();
+    void flush();
+    bool isEmpty();
+
+private:
+    char *buffer;
+    size_t bufferSize;
+    size_t len = 0;
+    void (*flushCallback)(const char *messages, size_t length);
+    unsigned long flushDeadline;
+    unsigned long firstMessageTime = 0;
+};
+
+// A ring of outgoing bytes in a caller supplied buffer, for sockets that may only take part of a write.
+// peek() gives the longest run of queued bytes that is contiguous in the buffer, and remove() frees however
+// many of them the socket accepted. add() is all or nothing, so a message is never queued in part.
+// As a Print, a MessageWriter can write straight into the queue. Check space() for the whole message first.
+class SendQueue : public Print {
+public:
+    SendQueue(char *_buffer, size_t _bufferSize);
+
+    bool add(const char *data, size_t dataLength); // Returns false, and queues nothing, if there isn't room
+    size_t write(uint8_t chr);
+    size_t write(const uint8_t *data, size_t dataLength);
+    size_t peek(const char **data);
+    void remove(size_t dataLength);
+    void clear();
+
+    size_t length();
+    size_t space();
+    size_t capacity();
+    bool isEmpty();
+
+private:
+    char *buffer;
+    size_t bufferSize;
+    size_t head = 0;
+    size_t len = 0;
+};
+
+#endif
@@ -48,8 +48,10 @@ void DashioBluno::checkForMessage() {
                 sendMessage(dashioDevice->getConnectMessage());
                 break;
             default:
-                if (messageData.control == config) {
-                    dashioDevice->dashboardID = messageData.idStr;
+                String configReply((char *)0);
+                if (dashioDevice->handleConfigRequest(messageData, configReply)) { // Reply from the config snapshot instead of the callback
+                    sendMessage(configReply);
+                    break;
                 }
                 processBLEmessageCallback(&messageData);
                 break;
@@ -79,14 +81,15 @@ void DashioBluno::begin(bool useMacForDeviceID) {
         while(Serial.available() > 0) {Serial.read();} // But first, clear the serial.
         Serial.println("AT+MAC=?");
         delay(1000); // Wait a while for reply
-        dashioDevice->deviceID = "";
+        String macStr((char *)0);
         while(Serial.available() > 0) {
             char c = Serial.read();
             if ((c == '\n') || (c == '\r')) { // Before the OK
                 break;
             }
-            dashioDevice->deviceID += c;
+            macStr += c;
         }
+        dashioDevice->setup(macStr);
         
         Serial.println("AT+EXIT");
         delay(1000);
@@ -25,6 +25,9 @@
 #if defined ESP32 || defined ESP8266
 
 #include "DashioESP.h"
+#ifdef ESP32
+    #include "DashioSocketESP32.h" // For non-blocking writes to the WiFiClient socket
+#endif
 
 #define WIFI_TIMEOUT_S 300 // Restart after 5 minutes
 
@@ -34,6 +37,10 @@ const int MQTT_RETRY_S = 10; // Retry after 10 seconds
 
 // BLE
 const int BLE_MAX_SEND_MESSAGE_LENGTH = 185; // 185 for iPhone 6, but can be up to 517
+const int TCP_MAX_CONFIG_PAGE_LENGTH = 1436; // One TCP segment
+const int TCP_READ_CHUNK_LENGTH = 256; // Bytes read from the socket at a time
+static_assert(TCP_MAX_CONFIG_PAGE_LENGTH <= TCP_SEND_BUFFER_SIZE, "A config page must fit in the TCP send queue");
+const int MQTT_PUBLISH_OVERHEAD = 9; // Fixed header, topic length and packet ID
 
 // ---------------------------------------- WiFi ---------------------------------------
 
@@ -192,14 +199,14 @@ void DashioSoftAP::run() {
 // ---------------------------------------- TCP ----------------------------------------
 
 #ifdef ESP32
-DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : data(TCP_CONN) {
+DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) {
     dashioDevice = _dashioDevice;
     tcpPort = _tcpPort;
     printMessages = _printMessages;
     wifiServer = WiFiServer(_tcpPort);
 }
 #elif ESP8266
-DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : wifiServer(_tcpPort), data(TCP_CONN) {
+DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : wifiServer(_tcpPort) {
     dashioDevice = _dashioDevice;
     tcpPort = _tcpPort;
     printMessages = _printMessages;
@@ -210,6 +217,10 @@ void DashioTCP::setCallback(void (*processIncomingMessage)(MessageData *messageD
     processTCPmessageCallback = processIncomingMessage;
 }
 
+void DashioTCP::setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested)) {
+    backpressureCallback = _backpressureCallback;
+}
+
 void DashioTCP::setPort(uint16_t _tcpPort) {
     tcpPort = _tcpPort;
 }
@@ -218,15 +229,193 @@ void DashioTCP::begin() {
     wifiServer.begin(tcpPort);
 }
 
+// In the callback this is a reply, e.g. to STATUS, so it goes only to the client that asked
 void DashioTCP::sendMessage(const String& message) {
-    if (client.connected()) {
-        client.print(message);
+    sendMessage(message.c_str(), message.length());
+}
+
+void DashioTCP::sendMessage(const char *message, size_t messageLength) {
+    if (currentClient >= 0) {
+        sendMessage(message, messageLength, currentClient);
+    } else {
+        sendMessageToAll(message, messageLength);
+    }
+}
+
+void DashioTCP::sendMessageToAll(const String& message) {
+    sendMessageToAll(message.c_str(), message.length());
+}
+
+void DashioTCP::sendMessageToAll(const char *message, size_t messageLength) {
+    bool sent = false;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].client.connected()) {
+            queueMessage(i, message, messageLength);
+            sent = true;
+        }
+    }
+
+    if (sent && printMessages) {
+        Serial.println(F("---- TCP Sent ----"));
+        Serial.write((const uint8_t *)message, messageLength);
+        Serial.println();
+    }
+}
+
+void DashioTCP::sendMessage(const String& message, int clientIndex) {
+    sendMessage(message.c_str(), message.length(), clientIndex);
+}
+
+void DashioTCP::sendMessage(const char *message, size_t messageLength, int clientIndex) {
+    if ((clientIndex < 0) || (clientIndex >= TCP_MAX_CLIENTS)) {
+        return;
+    }
+    TCPClient& tcpClient = clients[clientIndex];
+    if (tcpClient.active && tcpClient.client.connected()) {
+        queueMessage(clientIndex, message, messageLength);
 
         if (printMessages) {
-            Serial.println(F("---- TCP Sent ----"));
-            Serial.println(message);
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            Serial.write((const uint8_t *)message, messageLength);
+            Serial.println();
+        }
+    }
+}
+
+int DashioTCP::numClients() {
+    int count = 0;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool DashioTCP::isCongested() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].congested) {
+            return true;
         }
     }
+    return false;
+}
+
+void DashioTCP::setCoalescing(unsigned long windowMs, size_t threshold) {
+    coalesceWindow = windowMs;
+    coalesceThreshold = min(threshold, (size_t)TCP_SEND_BUFFER_SIZE);
+}
+
+// Messages too large for the queue are dropped, as a blocking write would hold up every other client
+void DashioTCP::queueMessage(int clientIndex, const char *message, size_t messageLength) {
+    TCPClient& tcpClient = clients[clientIndex];
+    bool wasEmpty = tcpClient.sendQueue.isEmpty();
+    if (!tcpClient.sendQueue.add(message, messageLength)) {
+        droppedMessages++; // The client isn't keeping up, or the message is larger than TCP_SEND_BUFFER_SIZE
+        return;
+    }
+    if (wasEmpty) {
+        tcpClient.firstQueuedTime = millis();
+    }
+    messagesSent++;
+    sendQueued(clientIndex);
+}
+
+void DashioTCP::sendQueued(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (readyToSend(clientIndex)) {
+        const char *data;
+        size_t dataLength;
+        while ((dataLength = tcpClient.sendQueue.peek(&data)) > 0) {
+            size_t written = writeToSocket(tcpClient.client, data, dataLength);
+            if (written > 0) {
+                tcpClient.sendQueue.remove(written);
+                segmentsSent++;
+            }
+            if (written < dataLength) { // The socket is full, so try again next run()
+                break;
+            }
+        }
+    }
+    checkBackpressure(clientIndex);
+}
+
+// When coalescing, the queue is held until it reaches the threshold or its oldest message has waited for the window
+bool DashioTCP::readyToSend(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (coalesceWindow == 0) {
+        return true;
+    }
+    return (tcpClient.sendQueue.length() >= coalesceThreshold) || (millis() - tcpClient.firstQueuedTime >= coalesceWindow);
+}
+
+// Writes only what the socket will take without waiting, so a slow client can't hold up the loop
+size_t DashioTCP::writeToSocket(WiFiClient& client, const char *data, size_t dataLength) {
+#ifdef ESP32
+    long written = socketSend(client.fd(), data, dataLength);
+    if (written < 0) {
+        if (written != SOCKET_WOULD_BLOCK) {
+            client.stop(); // Removed from the client table by run()
+        }
+        return 0;
+    }
+    return written;
+#else
+    size_t writeSpace = client.availableForWrite();
+    if (writeSpace == 0) {
+        return 0;
+    }
+    size_t written = client.write((const uint8_t *)data, min(dataLength, writeSpace));
+    if (written == 0) {
+        client.stop(); // There was room, so the write failed. Removed from the client table by run()
+    }
+    return written;
+#endif
+}
+
+void DashioTCP::setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs) {
+    idleTimeout = timeoutMs;
+    heartbeatInterval = (heartbeatMs > 0) ? heartbeatMs : timeoutMs;
+}
+
+// A client that has sent nothing for the heartbeat interval is sent a CONNECT heartbeat, which a live dashboard
+// answers. The socket takes the heartbeat even when the peer has gone, e.g. a phone that has left WiFi range, so only
+// a reply counts. A client that sends nothing within the idle timeout of its heartbeat is removed.
+bool DashioTCP::checkIdle(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    unsigned long now = millis();
+    if (tcpClient.heartbeatPending) {
+        if ((idleTimeout > 0) && (now - tcpClient.lastHeartbeatTime >= idleTimeout)) {
+            if (printMessages) {
+                Serial.print(F("TCP client timed out: "));
+                Serial.println(clientIndex);
+            }
+            return true;
+        }
+    } else if ((heartbeatInterval > 0) && (now - tcpClient.lastReceivedTime >= heartbeatInterval) && (now - tcpClient.lastHeartbeatTime >= heartbeatInterval)) {
+        tcpClient.lastHeartbeatTime = now;
+        tcpClient.heartbeatPending = true;
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+    }
+    return false;
+}
+
+// The callback is called once when a client's queue goes above the high-water mark, and once when it has drained
+void DashioTCP::checkBackpressure(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    size_t queued = tcpClient.sendQueue.length();
+    if (!tcpClient.congested && (queued >= TCP_SEND_HIGH_WATER)) {
+        tcpClient.congested = true;
+    } else if (tcpClient.congested && (queued < TCP_SEND_HIGH_WATER / 2)) {
+        tcpClient.congested = false;
+    } else {
+        return;
+    }
+
+    if (backpressureCallback != NULL) {
+        backpressureCallback(clientIndex, tcpClient.congested);
+    }
 }
 
 void DashioTCP::setupmDNSservice(const String& id) {
@@ -241,47 +430,164 @@ void DashioTCP::setupmDNSservice(const String& id) {
 }
     
 void DashioTCP::end() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            removeClient(i);
+        }
+    }
 #ifdef ESP8266
     MDNS.close();
 #endif
     MDNS.end();
 }
 
-void DashioTCP::run() {
-    if (!client) {
-        client = wifiServer.available();
-        client.setTimeout(2000);
-    } else {
-       if (client.connected()) {
-            while (client.available()>0) {
-                char c = client.read();
-                if (data.processChar(c)) {
-                    if (printMessages) {
-                        Serial.println(data.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(data.control)));
-                    }
-      
-                    switch (data.control) {
-                    case who:
-                        sendMessage(dashioDevice->getWhoMessage());
-                        break;
-                    case connect:
-                        sendMessage(dashioDevice->getConnectMessage());
-                        break;
-                    default:
-                        if (data.control == config) {
-                            dashioDevice->dashboardID = data.idStr;
-                        }
-                        if (processTCPmessageCallback != NULL) {
-                            processTCPmessageCallback(&data);
-                        }
-                        break;
-                    }
-                }
+// Each client's pages have its own dashboardID, so several clients can be sent config at the same time
+void DashioTCP::sendConfigPage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageWriter sizer;
+    size_t pageLength = dashioDevice->writeConfigPage(sizer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+    if (pageLength == 0) {
+        tcpClient.configPagePos = -1;
+    } else if (sizer.length() > TCP_SEND_BUFFER_SIZE) { // A single config message that can never be queued
+        droppedMessages++;
+        tcpClient.configPagePos += pageLength;
+    } else if (sizer.length() <= tcpClient.sendQueue.space()) { // Otherwise wait for the queue to drain
+        if (tcpClient.sendQueue.isEmpty()) {
+            tcpClient.firstQueuedTime = millis();
+        }
+        char buffer[32];
+        MessageWriter writer(buffer, sizeof(buffer), tcpClient.sendQueue);
+        dashioDevice->writeConfigPage(writer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+        writer.flush();
+        messagesSent++;
+
+        if (printMessages) {
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            MessageWriter printer(buffer, sizeof(buffer), Serial);
+            dashioDevice->writeConfigPage(printer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+            printer.flush();
+            Serial.println();
+        }
+        tcpClient.configPagePos += pageLength;
+        sendQueued(clientIndex);
+    }
+}
+
+void DashioTCP::addClient(WiFiClient& newClient) {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (!clients[i].active) {
+            clients[i].client = newClient;
+            clients[i].client.setTimeout(2000);
+            clients[i].data.reset();
+            clients[i].active = true;
+            clients[i].lastReceivedTime = millis();
+            clients[i].lastHeartbeatTime = clients[i].lastReceivedTime;
+            clients[i].heartbeatPending = false;
+
+            if (printMessages) {
+                Serial.print(F("TCP client connected: "));
+                Serial.println(i);
             }
-        } else {
-            client.stop();
-            client = wifiServer.available();
-            client.setTimeout(2000);
+            return;
+        }
+    }
+
+    newClient.stop(); // All the slots are in use
+    if (printMessages) {
+        Serial.println(F("TCP client refused"));
+    }
+}
+
+void DashioTCP::removeClient(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    tcpClient.client.stop();
+    tcpClient.configPagePos = -1;
+    tcpClient.dashboardID = "";
+    tcpClient.sendQueue.clear();
+    checkBackpressure(clientIndex); // Reports that a congested client no longer is
+    tcpClient.active = false;
+
+    if (printMessages) {
+        Serial.print(F("TCP client disconnected: "));
+        Serial.println(clientIndex);
+    }
+}
+
+void DashioTCP::runClient(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    sendQueued(clientIndex);
+    if (tcpClient.configPagePos >= 0) {
+        sendConfigPage(clientIndex);
+    }
+
+    char readBuffer[TCP_READ_CHUNK_LENGTH];
+    while (tcpClient.client.available() > 0) {
+        int readLength = tcpClient.client.read((uint8_t *)readBuffer, TCP_READ_CHUNK_LENGTH);
+        if (readLength <= 0) {
+            break;
+        }
+        tcpClient.lastReceivedTime = millis();
+        tcpClient.heartbeatPending = false; // Anything received shows the dashboard is still there
+        for (int i = 0; i < readLength; i++) {
+            if (tcpClient.data.processChar(readBuffer[i])) {
+                processMessage(clientIndex);
+            }
+        }
+    }
+}
+
+// Replies to WHO, CONNECT and config go only to the client that asked
+void DashioTCP::processMessage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageData& data = tcpClient.data;
+    if (printMessages) {
+        Serial.println(data.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(data.control)));
+    }
+
+    currentClient = clientIndex;
+    switch (data.control) {
+    case who:
+        sendMessage(dashioDevice->getWhoMessage(), clientIndex);
+        break;
+    case connect:
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+        break;
+    default:
+        String configReply((char *)0);
+        if (dashioDevice->handleConfigRequest(data, configReply, true)) { // Reply from the config snapshot instead of the callback
+            if (configReply.length() > 0) {
+                sendMessage(configReply, clientIndex);
+            } else {
+                tcpClient.dashboardID = data.idStr;
+                tcpClient.configPagePos = 0; // Sent a page at a time from run()
+                sendConfigPage(clientIndex);
+            }
+            break;
+        }
+        if (processTCPmessageCallback != NULL) {
+            processTCPmessageCallback(&data);
+        }
+        break;
+    }
+    currentClient = -1;
+}
+
+void DashioTCP::run() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && (!clients[i].client.connected() || checkIdle(i))) {
+            removeClient(i);
+        }
+    }
+
+    WiFiClient newClient = wifiServer.available();
+    if (newClient) {
+        addClient(newClient);
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            runClient(i);
         }
     }
     
@@ -294,25 +600,31 @@ void DashioTCP::run() {
 
 DashioMQTT::DashioMQTT(DashioDevice *_dashioDevice, int bufferSize, bool _sendRebootAlarm, bool _printMessages) : mqttClient(bufferSize) {
     dashioDevice = _dashioDevice;
+    mqttBufferSize = bufferSize;
     sendRebootAlarm  = _sendRebootAlarm;
     printMessages = _printMessages;
 }
 
-MessageData DashioMQTT::data(MQTT_CONN);
+QueuedMessageData DashioMQTT::data(MQTT_CONN);
 
 void DashioMQTT::messageReceivedMQTTCallback(MQTTClient *client, char *topic, char *payload, int payload_length) {
-    data.processMessage(String(payload)); // The message components are stored within the connection where the messageReceived flag is set
+    data.processMessage(payload, payload_length); // The message components are stored within the connection where the messageReceived flag is set
 }
 
 void DashioMQTT::sendMessage(const String& message, MQTTTopicType topic) {
+    sendMessage(message.c_str(), message.length(), topic);
+}
+
+void DashioMQTT::sendMessage(const char *message, size_t messageLength, MQTTTopicType topic) {
     if (mqttClient.connected()) {
         String publishTopic = dashioDevice->getMQTTTopic(username, topic);
-        mqttClient.publish(publishTopic.c_str(), message.c_str(), false, MQTT_QOS);
+        mqttClient.publish(publishTopic.c_str(), message, messageLength, false, MQTT_QOS);
 
         if (printMessages) {
             Serial.print(F("---- MQTT Sent ---- Topic: "));
             Serial.println(publishTopic);
-            Serial.println(message);
+            Serial.write((const uint8_t *)message, messageLength);
+            Serial.println();
         }
     }
 }
@@ -321,12 +633,29 @@ void DashioMQTT::sendAlarmMessage(const String& message) {
     sendMessage(message, alarm_topic);
 }
 
+// Pages fill the MQTT buffer, less the publish packet overhead
+void DashioMQTT::sendConfigPage() {
+    String publishTopic = dashioDevice->getMQTTTopic(username, data_topic);
+    size_t maxPageLength = mqttBufferSize - publishTopic.length() - MQTT_PUBLISH_OVERHEAD;
+    String page((char *)0);
+    page.reserve(maxPageLength);
+    MessageWriter writer(page);
+    size_t pageLength = dashioDevice->writeConfigPage(writer, configPagePos, maxPageLength, configDashboardID.c_str());
+    if (pageLength == 0) {
+        configPagePos = -1;
+    } else {
+        sendMessage(page);
+        configPagePos += pageLength;
+    }
+}
+
 void DashioMQTT::run() {
     if (mqttClient.connected()) {
         mqttClient.loop();
-        if (data.messageReceived) {
-            data.messageReceived = false;
-
+        if (configPagePos >= 0) {
+            sendConfigPage();
+        }
+        while (data.nextMessage()) {
             if (printMessages) {
                 Serial.println(data.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(data.control)));
             }
@@ -339,8 +668,16 @@ void DashioMQTT::run() {
                 sendMessage(dashioDevice->getConnectMessage());
                 break;
             default:
-                if (data.control == config) {
-                    dashioDevice->dashboardID = data.idStr;
+                String configReply((char *)0);
+                if (dashioDevice->handleConfigRequest(data, configReply, true)) { // Reply from the config snapshot instead of the callback
+                    if (configReply.length() > 0) {
+                        sendMessage(configReply);
+                    } else {
+                        configDashboardID = data.idStr;
+                        configPagePos = 0; // Sent a page at a time from run()
+                        sendConfigPage();
+                    }
+                    break;
                 }
                 if (processMQTTmessageCallback != NULL) {
                     processMQTTmessageCallback(&data);
@@ -477,7 +814,7 @@ class messageReceivedBLECallback: public BLECharacteristicCallbacks {
         
         void onWrite(BLECharacteristic *pCharacteristic) {
             std::string payload = pCharacteristic->getValue();
-            local_DashioBLE->data.processMessage(payload.c_str()); // The message components are stored within the connection where the messageReceived flag is set
+            local_DashioBLE->data.processMessage(payload.c_str(), payload.length()); // The message components are stored within the connection where the messageReceived flag is set
         }
     
     public:
@@ -489,47 +826,55 @@ DashioBLE::DashioBLE(DashioDevice *_dashioDevice, bool _printMessages) : data(BL
     printMessages = _printMessages;
 }
 
-void DashioBLE::bleNotifyValue(const String& message) {
-    pCharacteristic->setValue(message.c_str());
+void DashioBLE::bleNotifyValue(const char *message, size_t messageLength) {
+    pCharacteristic->setValue((uint8_t *)message, messageLength);
     pCharacteristic->notify();
 }
 
 void DashioBLE::sendMessage(const String& message) {
+    sendMessage(message.c_str(), message.length());
+}
+
+// Sent in notifications that fill the MTU, so a batch of short messages needs as few notifications as possible
+void DashioBLE::sendMessage(const char *message, size_t messageLength) {
     if (pServer->getConnectedCount() > 0) {
-        int maxMessageLength = BLEDevice::getMTU() - 3;
-        
-        if (message.length() <= maxMessageLength) {
-            bleNotifyValue(message);
-        } else {
-            int messageLength = message.length();
-            int numFullStrings = messageLength / maxMessageLength;
-    
-            String subStr((char *)0);
-            subStr.reserve(maxMessageLength);
-            
-            int start = 0;
-            for (unsigned int i = 0; i < numFullStrings; i++) {
-                subStr = message.substring(start, start + maxMessageLength);
-                bleNotifyValue(subStr);
-                start += maxMessageLength;
-            }
-            if (start < messageLength) {
-                subStr = message.substring(start);
-                bleNotifyValue(subStr);
-            }
+        size_t maxMessageLength = BLEDevice::getMTU() - 3;
+
+        size_t start = 0;
+        while (start < messageLength) {
+            size_t notifyLength = min(maxMessageLength, messageLength - start);
+            bleNotifyValue(message + start, notifyLength);
+            start += notifyLength;
         }
     
         if (printMessages) {
             Serial.println(F("---- BLE Sent ----"));
-            Serial.println(message);
+            Serial.write((const uint8_t *)message, messageLength);
+            Serial.println();
         }
     }
 }
     
+void DashioBLE::sendConfigPage() {
+    size_t maxPageLength = BLEDevice::getMTU() - 3;
+    String page((char *)0);
+    page.reserve(maxPageLength);
+    MessageWriter writer(page);
+    size_t pageLength = dashioDevice->writeConfigPage(writer, configPagePos, maxPageLength, configDashboardID.c_str());
+    if (pageLength == 0) {
+        configPagePos = -1;
+    } else {
+        sendMessage(page);
+        configPagePos += pageLength;
+    }
+}
+
 void DashioBLE::run() {
-     if (data.messageReceived) {
-        data.messageReceived = false;
+    if (configPagePos >= 0) {
+        sendConfigPage();
+    }
 
+     while (data.nextMessage()) {
         if (printMessages) {
             Serial.println(data.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(data.control)));
         }
@@ -542,8 +887,16 @@ void DashioBLE::run() {
             sendMessage(dashioDevice->getConnectMessage());
             break;
         default:
-            if (data.control == config) {
-                dashioDevice->dashboardID = data.idStr;
+            String configReply((char *)0);
+            if (dashioDevice->handleConfigRequest(data, configReply, true)) { // Reply from the config snapshot instead of the callback
+                if (configReply.length() > 0) {
+                    sendMessage(configReply);
+                } else {
+                    configDashboardID = data.idStr;
+                    configPagePos = 0; // Sent a page at a time from run()
+                    sendConfigPage();
+                }
+                break;
             }
             if (processBLEmessageCallback != NULL) {
                 processBLEmessageCallback(&data);
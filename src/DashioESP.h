@@ -51,23 +51,92 @@
 
 // ---------------------------------------- TCP ----------------------------------------
 
+// Each client takes its send buffer plus about 400 bytes, so the ESP8266 has fewer of them
+#ifndef TCP_MAX_CLIENTS
+#ifdef ESP8266
+#define TCP_MAX_CLIENTS 2 // Dashboards that can be connected at the same time
+#else
+#define TCP_MAX_CLIENTS 4
+#endif
+#endif
+
+#ifndef TCP_SEND_BUFFER_SIZE
+#define TCP_SEND_BUFFER_SIZE 2048 // Per client. Messages wait here until the socket can take them
+#endif
+
+#ifndef TCP_SEND_HIGH_WATER
+#define TCP_SEND_HIGH_WATER (TCP_SEND_BUFFER_SIZE * 3 / 4) // A client is congested above this, until its queue is below half of it
+#endif
+
+#ifndef TCP_COALESCE_THRESHOLD
+#define TCP_COALESCE_THRESHOLD 1436 // Coalesced writes go once this much is queued. One TCP segment
+#endif
+
 class DashioTCP {
 private:
+    // Each client has its own parser, so messages from different dashboards can't be mixed up
+    struct TCPClient {
+        WiFiClient client;
+        MessageData data;
+        String dashboardID = ((char *)0); // From the client's last config request
+        int configPagePos = -1; // Position of the next config page to send, or -1 when not sending config
+        bool active = false;
+        char sendBuffer[TCP_SEND_BUFFER_SIZE];
+        SendQueue sendQueue;
+        bool congested = false;
+        unsigned long firstQueuedTime = 0; // When the oldest queued message was added
+        unsigned long lastReceivedTime = 0;
+        unsigned long lastHeartbeatTime = 0;
+        bool heartbeatPending = false; // Sent a heartbeat, and nothing has been received since
+
+        TCPClient() : data(TCP_CONN), sendQueue(sendBuffer, TCP_SEND_BUFFER_SIZE) {}
+    };
+
     bool printMessages;
     DashioDevice *dashioDevice;
-    MessageData data;
-    WiFiClient client;
+    TCPClient clients[TCP_MAX_CLIENTS];
     WiFiServer wifiServer;
     void (*processTCPmessageCallback)(MessageData *messageData);
+    void (*backpressureCallback)(int clientIndex, bool congested) = NULL;
+    unsigned long coalesceWindow = 0;
+    size_t coalesceThreshold = TCP_COALESCE_THRESHOLD;
+    unsigned long idleTimeout = 0;
+    unsigned long heartbeatInterval = 0;
+
+    void addClient(WiFiClient& newClient);
+    void removeClient(int clientIndex);
+    void runClient(int clientIndex);
+    void processMessage(int clientIndex);
+    void sendConfigPage(int clientIndex);
+    void queueMessage(int clientIndex, const char *message, size_t messageLength);
+    void sendQueued(int clientIndex);
+    bool readyToSend(int clientIndex);
+    size_t writeToSocket(WiFiClient& client, const char *data, size_t dataLength);
+    void checkBackpressure(int clientIndex);
+    bool checkIdle(int clientIndex);
 
 public:
     uint16_t tcpPort = 5000;
+    int currentClient = -1; // The client whose message is being processed, e.g. to reply with sendMessage(message, tcp.currentClient)
+    unsigned int droppedMessages = 0; // Messages not sent because a client's send queue was full, or they were larger than it
+    unsigned long messagesSent = 0; // Counted once for each client a message goes to
+    unsigned long segmentsSent = 0; // Socket writes. Each is usually one TCP segment
 
     DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages = false);
     void setCallback(void (*processIncomingMessage)(MessageData *messageData));
+    void setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested));
     void setPort(uint16_t _tcpPort);
     void begin();
-    void sendMessage(const String& message);
+    void sendMessage(const String& message); // To the client whose message is being processed, or to every client outside the callback
+    void sendMessage(const char *message, size_t messageLength);
+    void sendMessage(const String& message, int clientIndex); // To one client
+    void sendMessage(const char *message, size_t messageLength, int clientIndex);
+    void sendMessageToAll(const String& message); // To every client, e.g. a value that every dashboard shows
+    void sendMessageToAll(const char *message, size_t messageLength);
+    int numClients();
+    bool isCongested(); // True while any client's send queue is above TCP_SEND_HIGH_WATER
+    void setCoalescing(unsigned long windowMs, size_t threshold = TCP_COALESCE_THRESHOLD); // A windowMs of 0 turns it off
+    void setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs = 0); // Removes a client that is silent for timeoutMs after a heartbeat. A heartbeatMs of 0 uses timeoutMs
     void setupmDNSservice(const String& id);
     void startupServer();
     void run();
@@ -82,7 +151,7 @@ private:
     bool reboot = true;
     bool printMessages;
     DashioDevice *dashioDevice;
-    static MessageData data;
+    static QueuedMessageData data;
     WiFiClientSecure wifiClient;
     MQTTClient mqttClient;
     int mqttConnectCount = 0;
@@ -90,10 +159,14 @@ private:
     char *username;
     char *password;
     void (*processMQTTmessageCallback)(MessageData *messageData);
+    int mqttBufferSize;
+    int configPagePos = -1; // Position of the next config page to send, or -1 when not sending config
+    String configDashboardID = ((char *)0); // Of the dashboard being sent config
 
     static void messageReceivedMQTTCallback(MQTTClient *client, char *topic, char *payload, int payload_length);
     void hostConnect();
     void setupLWT();
+    void sendConfigPage();
 
 public:
     char *mqttHost = DASH_SERVER;
@@ -103,6 +176,7 @@ public:
     DashioMQTT(DashioDevice *_dashioDevice, int bufferSize, bool _sendRebootAlarm, bool _printMessages = false);
     void setup(char *_username, char *_password);
     void sendMessage(const String& message, MQTTTopicType topic = data_topic);
+    void sendMessage(const char *message, size_t messageLength, MQTTTopicType topic = data_topic);
     void sendAlarmMessage(const String& message);
     void run();
     void checkConnection();
@@ -122,15 +196,19 @@ private:
     BLEService *pService;
     BLEAdvertising *pAdvertising;
     BLECharacteristic *pCharacteristic;
+    int configPagePos = -1; // Position of the next config page to send, or -1 when not sending config
+    String configDashboardID = ((char *)0); // Of the dashboard being sent config
 
-    void bleNotifyValue(const String& message);
+    void bleNotifyValue(const char *message, size_t messageLength);
+    void sendConfigPage();
 
 public:
-    MessageData data;
+    QueuedMessageData data;
     void (*processBLEmessageCallback)(MessageData *messageData);
 
     DashioBLE(DashioDevice *_dashioDevice, bool _printMessages = false);
     void sendMessage(const String& message);
+    void sendMessage(const char *message, size_t messageLength);
     void run();
     void setCallback(void (*processIncomingMessage)(MessageData *messageData));
     void begin(bool secureBLE = false);
@@ -0,0 +1,417 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+#if !defined ARDUINO && defined __linux__
+
+#include "DashioGateway.h"
+#include "DashioSocket.h"
+
+const int GATEWAY_READ_CHUNK_LENGTH = 4096; // Bytes read from a socket at a time
+const int GATEWAY_LISTEN_BACKLOG = 64;
+const int GATEWAY_MAX_EVENTS = 64; // Handled for each epoll wait
+
+// Tags for the sockets in the epoll set. Clients are tagged with their index in the client table.
+const int LISTEN_TAG = -1;
+const int FIRST_WATCH_TAG = -2; // Counting down
+
+DashioGateway::DashioGateway(uint16_t _tcpPort, bool _printMessages) : mqttData(MQTT_CONN) {
+    tcpPort = _tcpPort;
+    printMessages = _printMessages;
+}
+
+DashioGateway::~DashioGateway() {
+    end();
+}
+
+// Binary search of the sorted device table. Returns the index, or -1 if the deviceID isn't there.
+int DashioGateway::findDevice(const char *deviceID, size_t deviceIDLength) {
+    int low = 0;
+    int high = deviceCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        const String& midID = devices[mid].device->deviceID;
+        int compare = strncmp(midID.c_str(), deviceID, deviceIDLength);
+        if ((compare == 0) && (midID.length() > deviceIDLength)) {
+            compare = 1;
+        }
+        if (compare == 0) {
+            return mid;
+        } else if (compare < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return -1;
+}
+
+bool DashioGateway::addDevice(DashioDevice *device, void (*processIncomingMessage)(DashioDevice *device, MessageData *messageData)) {
+    if ((deviceCount >= GATEWAY_MAX_DEVICES) || (findDevice(device->deviceID.c_str(), device->deviceID.length()) >= 0)) {
+        return false;
+    }
+
+    int pos = deviceCount;
+    while ((pos > 0) && (strcmp(devices[pos - 1].device->deviceID.c_str(), device->deviceID.c_str()) > 0)) {
+        devices[pos] = devices[pos - 1];
+        pos--;
+    }
+    devices[pos].device = device;
+    devices[pos].processIncomingMessage = processIncomingMessage;
+    deviceCount++;
+    return true;
+}
+
+DashioDevice *DashioGateway::getDevice(const String& deviceID) {
+    int index = findDevice(deviceID.c_str(), deviceID.length());
+    return (index >= 0) ? devices[index].device : NULL;
+}
+
+int DashioGateway::numDevices() {
+    return deviceCount;
+}
+
+int DashioGateway::numClients() {
+    int count = 0;
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        if (clients[i].socket >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void DashioGateway::setMQTT(const String& username, void (*_mqttPublish)(const String& topic, const char *message, size_t messageLength)) {
+    mqttUsername = username;
+    mqttPublish = _mqttPublish;
+}
+
+bool DashioGateway::watchSocket(int socket, void (*ready)(int socket)) {
+    for (int i = 0; i < GATEWAY_MAX_WATCHES; i++) {
+        if (watches[i].socket < 0) {
+            if ((pollSocket >= 0) && !socketPollAdd(pollSocket, socket, FIRST_WATCH_TAG - i)) {
+                return false;
+            }
+            watches[i].socket = socket;
+            watches[i].ready = ready;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DashioGateway::unwatchSocket(int socket) {
+    for (int i = 0; i < GATEWAY_MAX_WATCHES; i++) {
+        if (watches[i].socket == socket) {
+            if (pollSocket >= 0) {
+                socketPollRemove(pollSocket, socket);
+            }
+            watches[i].socket = -1;
+            watches[i].ready = NULL;
+        }
+    }
+}
+
+bool DashioGateway::begin() {
+    end();
+
+    pollSocket = socketPollCreate();
+    serverSocket = socketListen(tcpPort, GATEWAY_LISTEN_BACKLOG);
+    if ((pollSocket < 0) || (serverSocket < 0) || !socketPollAdd(pollSocket, serverSocket, LISTEN_TAG)) {
+        end();
+        return false;
+    }
+
+    for (int i = 0; i < GATEWAY_MAX_WATCHES; i++) { // Watched before begin()
+        if (watches[i].socket >= 0) {
+            socketPollAdd(pollSocket, watches[i].socket, FIRST_WATCH_TAG - i);
+        }
+    }
+    return true;
+}
+
+void DashioGateway::end() {
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        if (clients[i].socket >= 0) {
+            removeClient(i);
+        }
+    }
+    if (serverSocket >= 0) {
+        socketClose(serverSocket);
+        serverSocket = -1;
+    }
+    if (pollSocket >= 0) {
+        socketClose(pollSocket);
+        pollSocket = -1;
+    }
+}
+
+void DashioGateway::run(int timeoutMs) {
+    if (pollSocket < 0) {
+        return;
+    }
+
+    SocketEvent events[GATEWAY_MAX_EVENTS];
+    int numEvents = socketPollWait(pollSocket, events, GATEWAY_MAX_EVENTS, timeoutMs);
+    for (int i = 0; i < numEvents; i++) {
+        SocketEvent& event = events[i];
+        if (event.tag == LISTEN_TAG) {
+            acceptClients();
+        } else if (event.tag <= FIRST_WATCH_TAG) {
+            SocketWatch& watch = watches[FIRST_WATCH_TAG - event.tag];
+            if ((watch.socket >= 0) && (watch.ready != NULL)) {
+                watch.ready(watch.socket);
+            }
+        } else if (clients[event.tag].socket >= 0) {
+            bool open = true;
+            if (event.writable) {
+                sendQueued(event.tag);
+            }
+            if (event.readable || event.closed) {
+                open = readClient(event.tag);
+            }
+            if (!open || (clients[event.tag].socket < 0)) {
+                removeClient(event.tag);
+            }
+        }
+    }
+}
+
+void DashioGateway::acceptClients() {
+    int clientSocket;
+    while ((clientSocket = socketAccept(serverSocket)) >= 0) {
+        addClient(clientSocket);
+    }
+}
+
+void DashioGateway::addClient(int clientSocket) {
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        GatewayClient& client = clients[i];
+        if (client.socket < 0) {
+            if (!socketPollAdd(pollSocket, clientSocket, i)) {
+                break;
+            }
+            client.socket = clientSocket;
+            client.data.reset();
+            client.sendQueue.clear();
+            client.waitingToWrite = false;
+
+            if (printMessages) {
+                Serial.print(F("Gateway client connected: "));
+                Serial.println(i);
+            }
+            return;
+        }
+    }
+
+    socketClose(clientSocket); // All the slots are in use
+    if (printMessages) {
+        Serial.println(F("Gateway client refused"));
+    }
+}
+
+void DashioGateway::removeClient(int clientIndex) {
+    GatewayClient& client = clients[clientIndex];
+    if (client.socket >= 0) {
+        socketPollRemove(pollSocket, client.socket);
+        socketClose(client.socket);
+        client.socket = -1;
+    }
+    client.sendQueue.clear();
+    client.waitingToWrite = false;
+
+    if (printMessages) {
+        Serial.print(F("Gateway client disconnected: "));
+        Serial.println(clientIndex);
+    }
+}
+
+// Returns false once the client has closed the connection or the socket has failed
+bool DashioGateway::readClient(int clientIndex) {
+    GatewayClient& client = clients[clientIndex];
+    char readBuffer[GATEWAY_READ_CHUNK_LENGTH];
+    while (client.socket >= 0) {
+        long readLength = socketReceive(client.socket, readBuffer, GATEWAY_READ_CHUNK_LENGTH);
+        if (readLength <= 0) {
+            return readLength == SOCKET_WOULD_BLOCK;
+        }
+
+        currentClient = clientIndex;
+        currentConnection = TCP_CONN;
+        for (long i = 0; i < readLength; i++) {
+            if (client.data.processChar(readBuffer[i])) {
+                routeMessage(client.data, client.data.deviceIDSpan);
+            }
+        }
+        currentClient = -1;
+    }
+    return false; // A write failed while processing the messages
+}
+
+// Writes what the socket will take, and polls for it to become writable again if anything is left
+void DashioGateway::sendQueued(int clientIndex) {
+    GatewayClient& client = clients[clientIndex];
+    const char *data;
+    size_t dataLength;
+    while ((dataLength = client.sendQueue.peek(&data)) > 0) {
+        long written = socketSend(client.socket, data, dataLength);
+        if (written == SOCKET_WOULD_BLOCK) {
+            break;
+        } else if (written < 0) {
+            socketPollRemove(pollSocket, client.socket);
+            socketClose(client.socket); // The slot is freed by run()
+            client.socket = -1;
+            return;
+        }
+        client.sendQueue.remove(written);
+    }
+
+    bool waitToWrite = !client.sendQueue.isEmpty();
+    if (waitToWrite != client.waitingToWrite) {
+        socketPollSetWritable(pollSocket, client.socket, clientIndex, waitToWrite);
+        client.waitingToWrite = waitToWrite;
+    }
+}
+
+// WHO is for every device in the gateway. Everything else goes to the device named at the start of the message.
+void DashioGateway::routeMessage(MessageData& data, const TextSpan& deviceID) {
+    if ((data.control == who) && (currentConnection == TCP_CONN)) {
+        if (printMessages) {
+            Serial.println(F("**** Gateway Received **** WHO"));
+        }
+        for (int i = 0; i < deviceCount; i++) {
+            sendReply(devices[i].device->getWhoMessage());
+        }
+        return;
+    }
+
+    int index = findDevice(deviceID.text, deviceID.length);
+    if (index < 0) {
+        unknownDeviceMessages++;
+        return;
+    }
+    messagesRouted++;
+    processDeviceMessage(devices[index], data);
+}
+
+void DashioGateway::processDeviceMessage(GatewayDevice& entry, MessageData& data) {
+    DashioDevice *device = entry.device;
+    if (printMessages) {
+        Serial.println(data.getReceivedMessageForPrint(device->getControlTypeStr(data.control)));
+    }
+
+    currentDevice = &entry;
+    switch (data.control) {
+    case who:
+        sendReply(device->getWhoMessage());
+        break;
+    case connect:
+        sendReply(device->getConnectMessage());
+        break;
+    default:
+        String configReply((char *)0);
+        if (device->handleConfigRequest(data, configReply)) { // Reply from the config snapshot instead of the callback
+            sendReply(configReply);
+            break;
+        }
+        if (entry.processIncomingMessage != NULL) {
+            entry.processIncomingMessage(device, &data);
+        }
+        break;
+    }
+    currentDevice = NULL;
+}
+
+// Each message is routed as soon as it is complete, so a publish may hold any number of them. The deviceID of a WHO
+// comes from the topic, <username>/<deviceID>/control, as the message doesn't have one.
+void DashioGateway::processMQTTMessage(const char *topic, const char *message, size_t messageLength) {
+    currentClient = -1;
+    currentConnection = MQTT_CONN;
+    for (size_t i = 0; i < messageLength; i++) {
+        if (!mqttData.processChar(message[i])) {
+            continue;
+        }
+
+        TextSpan deviceID = mqttData.deviceIDSpan;
+        if (mqttData.control == who) {
+            const char *idStart = strchr(topic, '/');
+            const char *idEnd = (idStart != NULL) ? strchr(idStart + 1, '/') : NULL;
+            if (idEnd == NULL) {
+                unknownDeviceMessages++;
+                continue;
+            }
+            deviceID = TextSpan(idStart + 1, idEnd - idStart - 1);
+        }
+        routeMessage(mqttData, deviceID);
+    }
+    currentConnection = TCP_CONN;
+}
+
+void DashioGateway::sendMessage(const String& message) {
+    sendMessage(message.c_str(), message.length());
+}
+
+void DashioGateway::sendMessage(const char *message, size_t messageLength) {
+    for (int i = 0; i < GATEWAY_MAX_CLIENTS; i++) {
+        if (clients[i].socket >= 0) {
+            sendMessage(message, messageLength, i);
+        }
+    }
+}
+
+void DashioGateway::sendMessage(const String& message, int clientIndex) {
+    sendMessage(message.c_str(), message.length(), clientIndex);
+}
+
+void DashioGateway::sendMessage(const char *message, size_t messageLength, int clientIndex) {
+    if ((clientIndex < 0) || (clientIndex >= GATEWAY_MAX_CLIENTS) || (clients[clientIndex].socket < 0)) {
+        return;
+    }
+    GatewayClient& client = clients[clientIndex];
+    if (!client.sendQueue.add(message, messageLength)) {
+        droppedMessages++; // The client isn't keeping up
+        return;
+    }
+    if (!client.waitingToWrite) { // Otherwise epoll says when the socket can take more
+        sendQueued(clientIndex);
+    }
+}
+
+void DashioGateway::sendMQTTMessage(DashioDevice *device, const String& message, MQTTTopicType topic) {
+    if (mqttPublish != NULL) {
+        mqttPublish(device->getMQTTTopic(mqttUsername, topic), message.c_str(), message.length());
+    }
+}
+
+void DashioGateway::sendReply(const String& message) {
+    if (currentConnection == MQTT_CONN) {
+        if (currentDevice != NULL) {
+            sendMQTTMessage(currentDevice->device, message);
+        }
+    } else {
+        sendMessage(message, currentClient);
+    }
+}
+
+#endif
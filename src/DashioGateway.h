@@ -0,0 +1,134 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Linux gateway that hosts many DashioDevices in one process, e.g. one for each serial or BLE sensor on an edge
+// gateway. All of the devices share one TCP port, served from a single epoll loop, and one MQTT connection.
+// Incoming messages are routed to their device by the deviceID at the start of each message.
+#if !defined ARDUINO && defined __linux__
+
+#ifndef DashioGateway_h
+#define DashioGateway_h
+
+#include "Arduino.h"
+#include "DashIO.h"
+
+#ifndef GATEWAY_MAX_DEVICES
+#define GATEWAY_MAX_DEVICES 1024
+#endif
+
+#ifndef GATEWAY_MAX_CLIENTS
+#define GATEWAY_MAX_CLIENTS 32 // Dashboards that can be connected at the same time
+#endif
+
+#ifndef GATEWAY_SEND_BUFFER_SIZE
+#define GATEWAY_SEND_BUFFER_SIZE 65536 // Per client. Large enough for the WHO replies from every device, or a whole config
+#endif
+
+#ifndef GATEWAY_MAX_WATCHES
+#define GATEWAY_MAX_WATCHES 4 // Other sockets served by the same loop, e.g. the MQTT connection
+#endif
+
+class DashioGateway {
+private:
+    struct GatewayDevice {
+        DashioDevice *device;
+        void (*processIncomingMessage)(DashioDevice *device, MessageData *messageData);
+    };
+
+    struct GatewayClient {
+        int socket = -1;
+        MessageData data;
+        char sendBuffer[GATEWAY_SEND_BUFFER_SIZE];
+        SendQueue sendQueue;
+        bool waitingToWrite = false; // Polling for the socket to become writable
+
+        GatewayClient() : data(TCP_CONN), sendQueue(sendBuffer, GATEWAY_SEND_BUFFER_SIZE) {}
+    };
+
+    struct SocketWatch {
+        int socket = -1;
+        void (*ready)(int socket) = NULL;
+    };
+
+    bool printMessages;
+    uint16_t tcpPort;
+    int serverSocket = -1;
+    int pollSocket = -1;
+    GatewayDevice devices[GATEWAY_MAX_DEVICES]; // Sorted by deviceID
+    int deviceCount = 0;
+    GatewayClient clients[GATEWAY_MAX_CLIENTS];
+    SocketWatch watches[GATEWAY_MAX_WATCHES];
+    MessageData mqttData;
+    String mqttUsername = ((char *)0);
+    void (*mqttPublish)(const String& topic, const char *message, size_t messageLength) = NULL;
+    ConnectionType currentConnection = TCP_CONN;
+    GatewayDevice *currentDevice = NULL;
+
+    int findDevice(const char *deviceID, size_t deviceIDLength);
+    void acceptClients();
+    void addClient(int clientSocket);
+    void removeClient(int clientIndex);
+    bool readClient(int clientIndex);
+    void sendQueued(int clientIndex);
+    void routeMessage(MessageData& data, const TextSpan& deviceID);
+    void processDeviceMessage(GatewayDevice& entry, MessageData& data);
+
+public:
+    int currentClient = -1; // The client whose message is being processed, or -1 for MQTT
+    unsigned int droppedMessages = 0; // Messages not sent because a client's send queue was full
+    unsigned long messagesRouted = 0; // Incoming messages passed to a device
+    unsigned long unknownDeviceMessages = 0; // Incoming messages for a deviceID that isn't in the gateway
+
+    DashioGateway(uint16_t _tcpPort, bool _printMessages = false);
+    ~DashioGateway();
+
+    // Call device->setup() first, as devices are found by their deviceID. Returns false if the deviceID is
+    // already in the gateway or there is no room for it.
+    bool addDevice(DashioDevice *device, void (*processIncomingMessage)(DashioDevice *device, MessageData *messageData));
+    DashioDevice *getDevice(const String& deviceID);
+    int numDevices();
+    int numClients();
+
+    // The application owns the MQTT connection. Its socket can be added with watchSocket() so that it is served by
+    // the same loop, messages it receives are passed to processMQTTMessage(), and the gateway publishes with mqttPublish.
+    void setMQTT(const String& username, void (*_mqttPublish)(const String& topic, const char *message, size_t messageLength));
+    void processMQTTMessage(const char *topic, const char *message, size_t messageLength);
+    bool watchSocket(int socket, void (*ready)(int socket));
+    void unwatchSocket(int socket);
+
+    bool begin(); // Returns false if the port can't be opened
+    void run(int timeoutMs = 0); // Waits up to timeoutMs for something to happen. 0 returns straight away
+    void end();
+
+    void sendMessage(const String& message); // To every TCP client
+    void sendMessage(const char *message, size_t messageLength);
+    void sendMessage(const String& message, int clientIndex); // To one TCP client
+    void sendMessage(const char *message, size_t messageLength, int clientIndex);
+    void sendMQTTMessage(DashioDevice *device, const String& message, MQTTTopicType topic = data_topic);
+    void sendReply(const String& message); // To whoever sent the message being processed, by TCP or MQTT
+};
+
+#endif
+#endif
@@ -40,18 +40,14 @@ DashioBLE::DashioBLE(DashioDevice *_dashioDevice, bool _printMessages) : bleServ
     bleService.addCharacteristic(bleCharacteristic);
 }
 
-MessageData DashioBLE::messageData(BLE_CONN);
+QueuedMessageData DashioBLE::messageData(BLE_CONN);
 
 void DashioBLE::onReadValueUpdate(BLEDevice central, BLECharacteristic characteristic) {
     // central wrote new value to characteristic
     int dataLength = characteristic.valueLength();
     char data[dataLength];
     int finalLength = characteristic.readValue(data, dataLength);
-    for (int i = 0; i < dataLength; i++) {
-        if (messageData.processChar(data[i])) {
-            messageData.messageReceived = true;
-        }
-    }
+    messageData.processMessage(data, finalLength);
 }
 
 void DashioBLE::setCallback(void (*processIncomingMessage)(MessageData *connection)) {
@@ -116,9 +112,7 @@ void DashioBLE::sendMessage(const String& message) {
 void DashioBLE::run() {
     if (BLE.connected()) {
         BLE.poll(); // Required for event handlers
-        if (messageData.messageReceived) {
-            messageData.messageReceived = false;
-    
+        while (messageData.nextMessage()) {
             if (printMessages) {
                 Serial.println(messageData.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(messageData.control)));
             }
@@ -131,8 +125,10 @@ void DashioBLE::run() {
                 sendMessage(dashioDevice->getConnectMessage());
                 break;
             default:
-                if (messageData.control == config) {
-                    dashioDevice->dashboardID = messageData.idStr;
+                String configReply((char *)0);
+                if (dashioDevice->handleConfigRequest(messageData, configReply)) { // Reply from the config snapshot instead of the callback
+                    sendMessage(configReply);
+                    break;
                 }
                 if (processBLEmessageCallback != NULL) {
                     processBLEmessageCallback(&messageData);
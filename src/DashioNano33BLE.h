@@ -40,7 +40,7 @@ class DashioBLE {
 private:
     bool printMessages;
     DashioDevice *dashioDevice;
-    static MessageData messageData;
+    static QueuedMessageData messageData;
     BLEService bleService;
     BLECharacteristic bleCharacteristic;
 
@@ -0,0 +1,415 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+#if !defined ARDUINO && (defined __unix__ || defined __APPLE__)
+
+#include "DashioPOSIX.h"
+#include "DashioSocket.h"
+
+const int TCP_MAX_CONFIG_PAGE_LENGTH = 1448; // One TCP segment
+const int TCP_READ_CHUNK_LENGTH = 4096; // Bytes read from the socket at a time
+const int TCP_LISTEN_BACKLOG = 16;
+static_assert(TCP_MAX_CONFIG_PAGE_LENGTH <= TCP_SEND_BUFFER_SIZE, "A config page must fit in the TCP send queue");
+
+// ---------------------------------------- TCP ----------------------------------------
+
+DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) {
+    dashioDevice = _dashioDevice;
+    tcpPort = _tcpPort;
+    printMessages = _printMessages;
+}
+
+DashioTCP::~DashioTCP() {
+    end();
+}
+
+void DashioTCP::setCallback(void (*processIncomingMessage)(MessageData *messageData)) {
+    processTCPmessageCallback = processIncomingMessage;
+}
+
+void DashioTCP::setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested)) {
+    backpressureCallback = _backpressureCallback;
+}
+
+void DashioTCP::setPort(uint16_t _tcpPort) {
+    tcpPort = _tcpPort;
+}
+
+bool DashioTCP::begin() {
+    end();
+    serverSocket = socketListen(tcpPort, TCP_LISTEN_BACKLOG);
+    return serverSocket >= 0;
+}
+
+void DashioTCP::end() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            removeClient(i);
+        }
+    }
+    if (serverSocket >= 0) {
+        socketClose(serverSocket);
+        serverSocket = -1;
+    }
+}
+
+// In the callback this is a reply, e.g. to STATUS, so it goes only to the client that asked
+void DashioTCP::sendMessage(const String& message) {
+    sendMessage(message.c_str(), message.length());
+}
+
+void DashioTCP::sendMessage(const char *message, size_t messageLength) {
+    if (currentClient >= 0) {
+        sendMessage(message, messageLength, currentClient);
+    } else {
+        sendMessageToAll(message, messageLength);
+    }
+}
+
+void DashioTCP::sendMessageToAll(const String& message) {
+    sendMessageToAll(message.c_str(), message.length());
+}
+
+void DashioTCP::sendMessageToAll(const char *message, size_t messageLength) {
+    bool sent = false;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            queueMessage(i, message, messageLength);
+            sent = true;
+        }
+    }
+
+    if (sent && printMessages) {
+        Serial.println(F("---- TCP Sent ----"));
+        Serial.write((const uint8_t *)message, messageLength);
+        Serial.println();
+    }
+}
+
+void DashioTCP::sendMessage(const String& message, int clientIndex) {
+    sendMessage(message.c_str(), message.length(), clientIndex);
+}
+
+void DashioTCP::sendMessage(const char *message, size_t messageLength, int clientIndex) {
+    if ((clientIndex < 0) || (clientIndex >= TCP_MAX_CLIENTS)) {
+        return;
+    }
+    if (clients[clientIndex].active) {
+        queueMessage(clientIndex, message, messageLength);
+
+        if (printMessages) {
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            Serial.write((const uint8_t *)message, messageLength);
+            Serial.println();
+        }
+    }
+}
+
+int DashioTCP::numClients() {
+    int count = 0;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool DashioTCP::isCongested() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].congested) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DashioTCP::setCoalescing(unsigned long windowMs, size_t threshold) {
+    coalesceWindow = windowMs;
+    coalesceThreshold = min(threshold, (size_t)TCP_SEND_BUFFER_SIZE);
+}
+
+void DashioTCP::setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs) {
+    idleTimeout = timeoutMs;
+    heartbeatInterval = (heartbeatMs > 0) ? heartbeatMs : timeoutMs;
+}
+
+// Messages too large for the queue are dropped, as there is no blocking write to fall back on
+void DashioTCP::queueMessage(int clientIndex, const char *message, size_t messageLength) {
+    TCPClient& tcpClient = clients[clientIndex];
+    bool wasEmpty = tcpClient.sendQueue.isEmpty();
+    if (!tcpClient.sendQueue.add(message, messageLength)) {
+        droppedMessages++;
+        return;
+    }
+    if (wasEmpty) {
+        tcpClient.firstQueuedTime = millis();
+    }
+    messagesSent++;
+    sendQueued(clientIndex);
+}
+
+void DashioTCP::sendQueued(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (readyToSend(clientIndex)) {
+        const char *data;
+        size_t dataLength;
+        while ((dataLength = tcpClient.sendQueue.peek(&data)) > 0) {
+            size_t written = writeToSocket(tcpClient, data, dataLength);
+            if (written > 0) {
+                tcpClient.sendQueue.remove(written);
+                segmentsSent++;
+            }
+            if (written < dataLength) { // The socket is full, so try again next run()
+                break;
+            }
+        }
+    }
+    checkBackpressure(clientIndex);
+}
+
+// When coalescing, the queue is held until it reaches the threshold or its oldest message has waited for the window
+bool DashioTCP::readyToSend(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (coalesceWindow == 0) {
+        return true;
+    }
+    return (tcpClient.sendQueue.length() >= coalesceThreshold) || (millis() - tcpClient.firstQueuedTime >= coalesceWindow);
+}
+
+size_t DashioTCP::writeToSocket(TCPClient& tcpClient, const char *data, size_t dataLength) {
+    long written = socketSend(tcpClient.socket, data, dataLength);
+    if (written < 0) {
+        if (written != SOCKET_WOULD_BLOCK) {
+            tcpClient.active = false; // Closed by run()
+        }
+        return 0;
+    }
+    return written;
+}
+
+// The callback is called once when a client's queue goes above the high-water mark, and once when it has drained
+void DashioTCP::checkBackpressure(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    size_t queued = tcpClient.sendQueue.length();
+    if (!tcpClient.congested && (queued >= TCP_SEND_HIGH_WATER)) {
+        tcpClient.congested = true;
+    } else if (tcpClient.congested && (queued < TCP_SEND_HIGH_WATER / 2)) {
+        tcpClient.congested = false;
+    } else {
+        return;
+    }
+
+    if (backpressureCallback != NULL) {
+        backpressureCallback(clientIndex, tcpClient.congested);
+    }
+}
+
+// A client that has sent nothing for the heartbeat interval is sent a CONNECT heartbeat, which a live dashboard
+// answers. The socket takes the heartbeat even when the peer has gone, e.g. a phone that has left WiFi range, so only
+// a reply counts. A client that sends nothing within the idle timeout of its heartbeat is removed.
+bool DashioTCP::checkIdle(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    unsigned long now = millis();
+    if (tcpClient.heartbeatPending) {
+        if ((idleTimeout > 0) && (now - tcpClient.lastHeartbeatTime >= idleTimeout)) {
+            if (printMessages) {
+                Serial.print(F("TCP client timed out: "));
+                Serial.println(clientIndex);
+            }
+            return true;
+        }
+    } else if ((heartbeatInterval > 0) && (now - tcpClient.lastReceivedTime >= heartbeatInterval) && (now - tcpClient.lastHeartbeatTime >= heartbeatInterval)) {
+        tcpClient.lastHeartbeatTime = now;
+        tcpClient.heartbeatPending = true;
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+    }
+    return false;
+}
+
+// Each client's pages have its own dashboardID, so several clients can be sent config at the same time
+void DashioTCP::sendConfigPage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageWriter sizer;
+    size_t pageLength = dashioDevice->writeConfigPage(sizer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+    if (pageLength == 0) {
+        tcpClient.configPagePos = -1;
+    } else if (sizer.length() > TCP_SEND_BUFFER_SIZE) { // A single config message that can never be queued
+        droppedMessages++;
+        tcpClient.configPagePos += pageLength;
+    } else if (sizer.length() <= tcpClient.sendQueue.space()) { // Otherwise wait for the queue to drain
+        if (tcpClient.sendQueue.isEmpty()) {
+            tcpClient.firstQueuedTime = millis();
+        }
+        char buffer[32];
+        MessageWriter writer(buffer, sizeof(buffer), tcpClient.sendQueue);
+        dashioDevice->writeConfigPage(writer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+        writer.flush();
+        messagesSent++;
+
+        if (printMessages) {
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            MessageWriter printer(buffer, sizeof(buffer), Serial);
+            dashioDevice->writeConfigPage(printer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+            printer.flush();
+            Serial.println();
+        }
+        tcpClient.configPagePos += pageLength;
+        sendQueued(clientIndex);
+    }
+}
+
+// Takes every connection that is waiting, so a burst of clients is accepted in one run()
+void DashioTCP::acceptClients() {
+    if (serverSocket < 0) {
+        return;
+    }
+
+    int clientSocket;
+    while ((clientSocket = socketAccept(serverSocket)) >= 0) {
+        addClient(clientSocket);
+    }
+}
+
+void DashioTCP::addClient(int clientSocket) {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (!clients[i].active) {
+            clients[i].socket = clientSocket;
+            clients[i].data.reset();
+            clients[i].active = true;
+            clients[i].lastReceivedTime = millis();
+            clients[i].lastHeartbeatTime = clients[i].lastReceivedTime;
+            clients[i].heartbeatPending = false;
+
+            if (printMessages) {
+                Serial.print(F("TCP client connected: "));
+                Serial.println(i);
+            }
+            return;
+        }
+    }
+
+    socketClose(clientSocket); // All the slots are in use
+    if (printMessages) {
+        Serial.println(F("TCP client refused"));
+    }
+}
+
+void DashioTCP::removeClient(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (tcpClient.socket >= 0) {
+        socketClose(tcpClient.socket);
+        tcpClient.socket = -1;
+    }
+    tcpClient.configPagePos = -1;
+    tcpClient.dashboardID = "";
+    tcpClient.sendQueue.clear();
+    checkBackpressure(clientIndex); // Reports that a congested client no longer is
+    tcpClient.active = false;
+
+    if (printMessages) {
+        Serial.print(F("TCP client disconnected: "));
+        Serial.println(clientIndex);
+    }
+}
+
+// Returns false once the client has closed the connection or the socket has failed
+bool DashioTCP::runClient(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    sendQueued(clientIndex);
+    if (tcpClient.configPagePos >= 0) {
+        sendConfigPage(clientIndex);
+    }
+
+    char readBuffer[TCP_READ_CHUNK_LENGTH];
+    while (tcpClient.active) {
+        long readLength = socketReceive(tcpClient.socket, readBuffer, TCP_READ_CHUNK_LENGTH);
+        if (readLength <= 0) {
+            return readLength == SOCKET_WOULD_BLOCK;
+        }
+
+        tcpClient.lastReceivedTime = millis();
+        tcpClient.heartbeatPending = false; // Anything received shows the dashboard is still there
+        for (long i = 0; i < readLength; i++) {
+            if (tcpClient.data.processChar(readBuffer[i])) {
+                processMessage(clientIndex);
+            }
+        }
+    }
+    return false; // A write failed while processing the messages
+}
+
+// Replies to WHO, CONNECT and config go only to the client that asked
+void DashioTCP::processMessage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageData& data = tcpClient.data;
+    if (printMessages) {
+        Serial.println(data.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(data.control)));
+    }
+
+    currentClient = clientIndex;
+    switch (data.control) {
+    case who:
+        sendMessage(dashioDevice->getWhoMessage(), clientIndex);
+        break;
+    case connect:
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+        break;
+    default:
+        String configReply((char *)0);
+        if (dashioDevice->handleConfigRequest(data, configReply, true)) { // Reply from the config snapshot instead of the callback
+            if (configReply.length() > 0) {
+                sendMessage(configReply, clientIndex);
+            } else {
+                tcpClient.dashboardID = data.idStr;
+                tcpClient.configPagePos = 0; // Sent a page at a time from run()
+                sendConfigPage(clientIndex);
+            }
+            break;
+        }
+        if (processTCPmessageCallback != NULL) {
+            processTCPmessageCallback(&data);
+        }
+        break;
+    }
+    currentClient = -1;
+}
+
+void DashioTCP::run() {
+    acceptClients();
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].socket < 0) {
+            continue;
+        }
+        if (!clients[i].active || checkIdle(i) || !runClient(i)) {
+            removeClient(i);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Host build of DashioTCP on non-blocking POSIX sockets, for running dashboards and message handlers on Linux or
+// macOS without hardware, e.g. load tests over loopback or replaying recorded sessions. It has the same API as the
+// board versions. extras/host has an Arduino.h for the host, and a load test and session replay built with make.
+#if !defined ARDUINO && (defined __unix__ || defined __APPLE__)
+
+#ifndef DashioPOSIX_h
+#define DashioPOSIX_h
+
+#include "Arduino.h"
+#include "DashIO.h"
+
+// ---------------------------------------- TCP ----------------------------------------
+
+#ifndef TCP_MAX_CLIENTS
+#define TCP_MAX_CLIENTS 16 // Dashboards that can be connected at the same time
+#endif
+
+#ifndef TCP_SEND_BUFFER_SIZE
+#define TCP_SEND_BUFFER_SIZE 16384 // Per client. Messages wait here until the socket can take them
+#endif
+
+#ifndef TCP_SEND_HIGH_WATER
+#define TCP_SEND_HIGH_WATER (TCP_SEND_BUFFER_SIZE * 3 / 4) // A client is congested above this, until its queue is below half of it
+#endif
+
+#ifndef TCP_COALESCE_THRESHOLD
+#define TCP_COALESCE_THRESHOLD 1448 // Coalesced writes go once this much is queued. One TCP segment
+#endif
+
+class DashioTCP {
+private:
+    // Each client has its own parser, so messages from different dashboards can't be mixed up
+    struct TCPClient {
+        int socket = -1;
+        MessageData data;
+        String dashboardID = ((char *)0); // From the client's last config request
+        int configPagePos = -1; // Position of the next config page to send, or -1 when not sending config
+        bool active = false;
+        char sendBuffer[TCP_SEND_BUFFER_SIZE];
+        SendQueue sendQueue;
+        bool congested = false;
+        unsigned long firstQueuedTime = 0; // When the oldest queued message was added
+        unsigned long lastReceivedTime = 0;
+        unsigned long lastHeartbeatTime = 0;
+        bool heartbeatPending = false; // Sent a heartbeat, and nothing has been received since
+
+        TCPClient() : data(TCP_CONN), sendQueue(sendBuffer, TCP_SEND_BUFFER_SIZE) {}
+    };
+
+    bool printMessages;
+    DashioDevice *dashioDevice;
+    TCPClient clients[TCP_MAX_CLIENTS];
+    int serverSocket = -1;
+    void (*processTCPmessageCallback)(MessageData *messageData) = NULL;
+    void (*backpressureCallback)(int clientIndex, bool congested) = NULL;
+    unsigned long coalesceWindow = 0;
+    size_t coalesceThreshold = TCP_COALESCE_THRESHOLD;
+    unsigned long idleTimeout = 0;
+    unsigned long heartbeatInterval = 0;
+
+    void acceptClients();
+    void addClient(int clientSocket);
+    void removeClient(int clientIndex);
+    bool runClient(int clientIndex);
+    void processMessage(int clientIndex);
+    void sendConfigPage(int clientIndex);
+    void queueMessage(int clientIndex, const char *message, size_t messageLength);
+    void sendQueued(int clientIndex);
+    bool readyToSend(int clientIndex);
+    size_t writeToSocket(TCPClient& tcpClient, const char *data, size_t dataLength);
+    void checkBackpressure(int clientIndex);
+    bool checkIdle(int clientIndex);
+
+public:
+    uint16_t tcpPort = 5000;
+    int currentClient = -1; // The client whose message is being processed, e.g. to reply with sendMessage(message, tcp.currentClient)
+    unsigned int droppedMessages = 0; // Messages not sent because a client's send queue was full, or they were larger than it
+    unsigned long messagesSent = 0; // Counted once for each client a message goes to
+    unsigned long segmentsSent = 0; // Socket writes. Each is usually one TCP segment
+
+    DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages = false);
+    ~DashioTCP();
+    void setCallback(void (*processIncomingMessage)(MessageData *messageData));
+    void setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested));
+    void setPort(uint16_t _tcpPort);
+    bool begin(); // Returns false if the port can't be opened
+    void sendMessage(const String& message); // To the client whose message is being processed, or to every client outside the callback
+    void sendMessage(const char *message, size_t messageLength);
+    void sendMessage(const String& message, int clientIndex); // To one client
+    void sendMessage(const char *message, size_t messageLength, int clientIndex);
+    void sendMessageToAll(const String& message); // To every client, e.g. a value that every dashboard shows
+    void sendMessageToAll(const char *message, size_t messageLength);
+    int numClients();
+    bool isCongested(); // True while any client's send queue is above TCP_SEND_HIGH_WATER
+    void setCoalescing(unsigned long windowMs, size_t threshold = TCP_COALESCE_THRESHOLD); // A windowMs of 0 turns it off
+    void setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs = 0); // Removes a client that is silent for timeoutMs after a heartbeat. A heartbeatMs of 0 uses timeoutMs
+    void run(); // Never blocks, so call it from the application's own loop
+    void end();
+};
+
+#endif
+#endif
@@ -39,6 +39,12 @@ const int     MQTT_RETRY_S = 10; // Retry after 10 seconds
 // BLE
 const int BLE_MAX_SEND_MESSAGE_LENGTH = 100;
 
+// TCP
+const int TCP_MAX_CONFIG_PAGE_LENGTH = 512;
+const int TCP_MAX_WRITE_LENGTH = 256; // Each write is an SPI transfer to the NINA module, so they are kept short
+const int TCP_READ_CHUNK_LENGTH = 128; // Bytes read from the NINA module in one SPI transfer
+static_assert(TCP_MAX_CONFIG_PAGE_LENGTH <= TCP_SEND_BUFFER_SIZE, "A config page must fit in the TCP send queue");
+
 /*???
 // mDNS
 WiFiUDP udp;
@@ -162,7 +168,7 @@ String DashioWiFi::ipAddress() {
 // ---------------------------------------- TCP ----------------------------------------
 
 //???DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : wifiServer(_tcpPort), mdns(udp), messageData(TCP_CONN) {
-DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : wifiServer(_tcpPort), messageData(TCP_CONN) {
+DashioTCP::DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : wifiServer(_tcpPort) {
     dashioDevice = _dashioDevice;
     tcpPort = _tcpPort;
     printMessages = _printMessages;
@@ -172,17 +178,192 @@ void DashioTCP::setCallback(void (*processIncomingMessage)(MessageData *connecti
     processTCPmessageCallback = processIncomingMessage;
 }
 
+void DashioTCP::setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested)) {
+    backpressureCallback = _backpressureCallback;
+}
+
+// In the callback this is a reply, e.g. to STATUS, so it goes only to the client that asked
 void DashioTCP::sendMessage(const String& message) {
-    if (client.connected()) {
-        client.print(message);
+    if (currentClient >= 0) {
+        sendMessage(message, currentClient);
+    } else {
+        sendMessageToAll(message);
+    }
+}
+
+void DashioTCP::sendMessageToAll(const String& message) {
+    bool sent = false;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].client.connected()) {
+            queueMessage(i, message.c_str(), message.length());
+            sent = true;
+        }
+    }
+
+    if (sent && printMessages) {
+        Serial.println(F("---- TCP Sent ----"));
+        Serial.println(message);
+    }
+}
+
+void DashioTCP::sendMessage(const String& message, int clientIndex) {
+    if ((clientIndex < 0) || (clientIndex >= TCP_MAX_CLIENTS)) {
+        return;
+    }
+    TCPClient& tcpClient = clients[clientIndex];
+    if (tcpClient.active && tcpClient.client.connected()) {
+        queueMessage(clientIndex, message.c_str(), message.length());
 
         if (printMessages) {
-            Serial.println(F("---- TCP Sent ----"));
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
             Serial.println(message);
         }
     }
 }
 
+int DashioTCP::numClients() {
+    int count = 0;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool DashioTCP::isCongested() {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].congested) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DashioTCP::setCoalescing(unsigned long windowMs, size_t threshold) {
+    coalesceWindow = windowMs;
+    coalesceThreshold = min(threshold, (size_t)TCP_SEND_BUFFER_SIZE);
+}
+
+// Messages too large for the queue are dropped, as a blocking write would hold up every other client
+void DashioTCP::queueMessage(int clientIndex, const char *message, size_t messageLength) {
+    TCPClient& tcpClient = clients[clientIndex];
+    bool wasEmpty = tcpClient.sendQueue.isEmpty();
+    if (!tcpClient.sendQueue.add(message, messageLength)) {
+        droppedMessages++; // The client isn't keeping up, or the message is larger than TCP_SEND_BUFFER_SIZE
+        return;
+    }
+    if (wasEmpty) {
+        tcpClient.firstQueuedTime = millis();
+    }
+    messagesSent++;
+    sendQueued(clientIndex);
+}
+
+// Writes at most TCP_MAX_WRITE_LENGTH per client each run(), so a slow client can't hold up the loop for long
+void DashioTCP::sendQueued(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    const char *data;
+    size_t dataLength = tcpClient.sendQueue.peek(&data);
+    if ((dataLength > 0) && readyToSend(clientIndex)) {
+        size_t written = tcpClient.client.write((const uint8_t *)data, min(dataLength, (size_t)TCP_MAX_WRITE_LENGTH));
+        if (written > 0) {
+            tcpClient.sendQueue.remove(written);
+            segmentsSent++;
+        } else if (tcpClient.client.getWriteError()) {
+            tcpClient.client.stop(); // Removed from the client table by run()
+        }
+    }
+    checkBackpressure(clientIndex);
+}
+
+// When coalescing, the queue is held until it reaches the threshold or its oldest message has waited for the window
+bool DashioTCP::readyToSend(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    if (coalesceWindow == 0) {
+        return true;
+    }
+    return (tcpClient.sendQueue.length() >= coalesceThreshold) || (millis() - tcpClient.firstQueuedTime >= coalesceWindow);
+}
+
+void DashioTCP::setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs) {
+    idleTimeout = timeoutMs;
+    heartbeatInterval = (heartbeatMs > 0) ? heartbeatMs : timeoutMs;
+}
+
+// A client that has sent nothing for the heartbeat interval is sent a CONNECT heartbeat, which a live dashboard
+// answers. The socket takes the heartbeat even when the peer has gone, e.g. a phone that has left WiFi range, so only
+// a reply counts. A client that sends nothing within the idle timeout of its heartbeat is removed.
+bool DashioTCP::checkIdle(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    unsigned long now = millis();
+    if (tcpClient.heartbeatPending) {
+        if ((idleTimeout > 0) && (now - tcpClient.lastHeartbeatTime >= idleTimeout)) {
+            if (printMessages) {
+                Serial.print(F("TCP client timed out: "));
+                Serial.println(clientIndex);
+            }
+            return true;
+        }
+    } else if ((heartbeatInterval > 0) && (now - tcpClient.lastReceivedTime >= heartbeatInterval) && (now - tcpClient.lastHeartbeatTime >= heartbeatInterval)) {
+        tcpClient.lastHeartbeatTime = now;
+        tcpClient.heartbeatPending = true;
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+    }
+    return false;
+}
+
+// The callback is called once when a client's queue goes above the high-water mark, and once when it has drained
+void DashioTCP::checkBackpressure(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    size_t queued = tcpClient.sendQueue.length();
+    if (!tcpClient.congested && (queued >= TCP_SEND_HIGH_WATER)) {
+        tcpClient.congested = true;
+    } else if (tcpClient.congested && (queued < TCP_SEND_HIGH_WATER / 2)) {
+        tcpClient.congested = false;
+    } else {
+        return;
+    }
+
+    if (backpressureCallback != NULL) {
+        backpressureCallback(clientIndex, tcpClient.congested);
+    }
+}
+
+// Each client's pages have its own dashboardID, so several clients can be sent config at the same time
+void DashioTCP::sendConfigPage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageWriter sizer;
+    size_t pageLength = dashioDevice->writeConfigPage(sizer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+    if (pageLength == 0) {
+        tcpClient.configPagePos = -1;
+    } else if (sizer.length() > TCP_SEND_BUFFER_SIZE) { // A single config message that can never be queued
+        droppedMessages++;
+        tcpClient.configPagePos += pageLength;
+    } else if (sizer.length() <= tcpClient.sendQueue.space()) { // Otherwise wait for the queue to drain
+        if (tcpClient.sendQueue.isEmpty()) {
+            tcpClient.firstQueuedTime = millis();
+        }
+        char buffer[32];
+        MessageWriter writer(buffer, sizeof(buffer), tcpClient.sendQueue);
+        dashioDevice->writeConfigPage(writer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+        writer.flush();
+        messagesSent++;
+
+        if (printMessages) {
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            MessageWriter printer(buffer, sizeof(buffer), Serial);
+            dashioDevice->writeConfigPage(printer, tcpClient.configPagePos, TCP_MAX_CONFIG_PAGE_LENGTH, tcpClient.dashboardID.c_str());
+            printer.flush();
+            Serial.println();
+        }
+        tcpClient.configPagePos += pageLength;
+        sendQueued(clientIndex);
+    }
+}
+
 void DashioTCP::begin() {
     wifiServer.begin();
 
@@ -193,54 +374,142 @@ void DashioTCP::begin() {
 */
 }
 
+// WiFiServer::available() returns any client with data waiting, so it may be one that is already in the table
+void DashioTCP::addClient(WiFiClient& newClient) {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && (clients[i].client == newClient)) {
+            return;
+        }
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (!clients[i].active) {
+            clients[i].client = newClient;
+            clients[i].client.setTimeout(2000);
+            clients[i].messageData.reset();
+            clients[i].active = true;
+            clients[i].lastReceivedTime = millis();
+            clients[i].lastHeartbeatTime = clients[i].lastReceivedTime;
+            clients[i].heartbeatPending = false;
+
+            if (printMessages) {
+                Serial.print(F("TCP client connected: "));
+                Serial.println(i);
+            }
+            return;
+        }
+    }
+
+    newClient.stop(); // All the slots are in use
+    if (printMessages) {
+        Serial.println(F("TCP client refused"));
+    }
+}
+
+void DashioTCP::removeClient(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    tcpClient.client.stop();
+    tcpClient.configPagePos = -1;
+    tcpClient.dashboardID = "";
+    tcpClient.sendQueue.clear();
+    checkBackpressure(clientIndex); // Reports that a congested client no longer is
+    tcpClient.active = false;
+
+    if (printMessages) {
+        Serial.print(F("TCP client disconnected: "));
+        Serial.println(clientIndex);
+    }
+}
+
+// Replies to WHO, CONNECT and config go only to the client that asked
+void DashioTCP::processMessage(int clientIndex) {
+    TCPClient& tcpClient = clients[clientIndex];
+    MessageData& messageData = tcpClient.messageData;
+    if (printMessages) {
+        Serial.println(messageData.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(messageData.control)));
+    }
+
+    currentClient = clientIndex;
+    switch (messageData.control) {
+    case who:
+        sendMessage(dashioDevice->getWhoMessage(), clientIndex);
+        break;
+    case connect:
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+        break;
+    default:
+        String configReply((char *)0);
+        if (dashioDevice->handleConfigRequest(messageData, configReply, true)) { // Reply from the config snapshot instead of the callback
+            if (configReply.length() > 0) {
+                sendMessage(configReply, clientIndex);
+            } else {
+                tcpClient.dashboardID = messageData.idStr;
+                tcpClient.configPagePos = 0; // Sent a page at a time from run()
+                sendConfigPage(clientIndex);
+            }
+            break;
+        }
+        if (processTCPmessageCallback != NULL) {
+            processTCPmessageCallback(&messageData);
+        }
+        break;
+    }
+    currentClient = -1;
+}
+
 void DashioTCP::run() {
 //???    mdns.run();
 
-    if (!client) {
-        client = wifiServer.available();
-        client.setTimeout(2000);
-    } else {
-       if (client.connected()) {
-            while (client.available()>0) {
-                char c = client.read();
-                if (messageData.processChar(c)) {
-                    if (printMessages) {
-                        Serial.println(messageData.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(messageData.control)));
-                    }
-      
-                    switch (messageData.control) {
-                    case who:
-                        sendMessage(dashioDevice->getWhoMessage());
-                        break;
-                    case connect:
-                        sendMessage(dashioDevice->getConnectMessage());
-                        break;
-                    default:
-                        if (messageData.control == config) {
-                            dashioDevice->dashboardID = messageData.idStr;
-                        }
-                        if (processTCPmessageCallback != NULL) {
-                            processTCPmessageCallback(&messageData);
-                        }
-                        break;
-                    }
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && (!clients[i].client.connected() || checkIdle(i))) {
+            removeClient(i);
+        }
+    }
+
+    WiFiClient newClient = wifiServer.available();
+    if (newClient) {
+        addClient(newClient);
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        TCPClient& tcpClient = clients[i];
+        if (!tcpClient.active) {
+            continue;
+        }
+
+        sendQueued(i);
+        if (tcpClient.configPagePos >= 0) {
+            sendConfigPage(i);
+        }
+
+        char readBuffer[TCP_READ_CHUNK_LENGTH];
+        while (tcpClient.client.available() > 0) {
+            int readLength = tcpClient.client.read((uint8_t *)readBuffer, TCP_READ_CHUNK_LENGTH);
+            if (readLength <= 0) {
+                break;
+            }
+            tcpClient.lastReceivedTime = millis();
+            tcpClient.heartbeatPending = false; // Anything received shows the dashboard is still there
+            for (int j = 0; j < readLength; j++) {
+                if (tcpClient.messageData.processChar(readBuffer[j])) {
+                    processMessage(i);
                 }
             }
-        } else {
-            client.stop();
-            client = wifiServer.available();
-            client.setTimeout(2000);
         }
     }
 }
 
 void DashioTCP::end() {
-    client.stop();
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            removeClient(i);
+        }
+    }
 }
 
 // ---------------------------------------- MQTT ---------------------------------------
 
-MessageData DashioMQTT::messageData(MQTT_CONN);
+QueuedMessageData DashioMQTT::messageData(MQTT_CONN);
 WiFiSSLClient DashioMQTT::wifiClient;
 MqttClient DashioMQTT::mqttClient(wifiClient);
 
@@ -251,11 +520,15 @@ DashioMQTT::DashioMQTT(DashioDevice *_dashioDevice, bool _sendRebootAlarm, bool
 }
 
 void DashioMQTT::messageReceivedMQTTCallback(int messageSize) {
-    String message;
-    for (int i = 0; i < messageSize; i++) {
-        message += (char)mqttClient.read();
+    char message[MESSAGE_BUFFER_LEN];
+    while (messageSize > 0) {
+        int readLength = mqttClient.read((uint8_t *)message, min(messageSize, MESSAGE_BUFFER_LEN));
+        if (readLength <= 0) {
+            break;
+        }
+        messageData.processMessage(message, readLength); // The message components are stored within the connection where the messageReceived flag is set
+        messageSize -= readLength;
     }
-    messageData.processMessage(message); // The message components are stored within the connection where the messageReceived flag is set
 }
 
 
@@ -281,9 +554,7 @@ void DashioMQTT::sendAlarmMessage(const String& message) {
 void DashioMQTT::run() {
     mqttClient.poll();
     if (mqttClient.connected()) {
-        if (messageData.messageReceived) {
-            messageData.messageReceived = false;
-
+        while (messageData.nextMessage()) {
             if (printMessages) {
                 Serial.println(messageData.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(messageData.control)));
             }
@@ -296,8 +567,10 @@ void DashioMQTT::run() {
                 sendMessage(dashioDevice->getConnectMessage());
                 break;
             default:
-                if (messageData.control == config) {
-                    dashioDevice->dashboardID = messageData.idStr;
+                String configReply((char *)0);
+                if (dashioDevice->handleConfigRequest(messageData, configReply)) { // Reply from the config snapshot instead of the callback
+                    sendMessage(configReply);
+                    break;
                 }
                 if (processMQTTmessageCallback != NULL) {
                     processMQTTmessageCallback(&messageData);
@@ -394,18 +667,14 @@ DashioBLE::DashioBLE(DashioDevice *_dashioDevice, bool _printMessages) : bleServ
     bleService.addCharacteristic(bleCharacteristic);
 }
 
-MessageData DashioBLE::messageData(BLE_CONN);
+QueuedMessageData DashioBLE::messageData(BLE_CONN);
 
 void DashioBLE::onReadValueUpdate(BLEDevice central, BLECharacteristic characteristic) {
     // central wrote new value to characteristic
     int dataLength = characteristic.valueLength();
     char data[dataLength];
     int finalLength = characteristic.readValue(data, dataLength);
-    for (int i = 0; i < dataLength; i++) {
-        if (messageData.processChar(data[i])) {
-            messageData.messageReceived = true;
-        }
-    }
+    messageData.processMessage(data, finalLength);
 }
 
 void DashioBLE::setCallback(void (*processIncomingMessage)(MessageData *connection)) {
@@ -470,9 +739,7 @@ void DashioBLE::sendMessage(const String& message) {
 void DashioBLE::run() {
     if (BLE.connected()) {
         BLE.poll(); // Required for event handlers
-        if (messageData.messageReceived) {
-            messageData.messageReceived = false;
-    
+        while (messageData.nextMessage()) {
             if (printMessages) {
                 Serial.println(messageData.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(messageData.control)));
             }
@@ -485,8 +752,10 @@ void DashioBLE::run() {
                 sendMessage(dashioDevice->getConnectMessage());
                 break;
             default:
-                if (messageData.control == config) {
-                    dashioDevice->dashboardID = messageData.idStr;
+                String configReply((char *)0);
+                if (dashioDevice->handleConfigRequest(messageData, configReply)) { // Reply from the config snapshot instead of the callback
+                    sendMessage(configReply);
+                    break;
                 }
                 if (processBLEmessageCallback != NULL) {
                     processBLEmessageCallback(&messageData);
@@ -56,13 +56,46 @@
 
 // ---------------------------------------- TCP ----------------------------------------
 
+#ifndef TCP_MAX_CLIENTS
+#define TCP_MAX_CLIENTS 2 // Dashboards that can be connected at the same time
+#endif
+
+#ifndef TCP_SEND_BUFFER_SIZE
+#define TCP_SEND_BUFFER_SIZE 1024 // Per client. Messages wait here until the socket can take them
+#endif
+
+#ifndef TCP_SEND_HIGH_WATER
+#define TCP_SEND_HIGH_WATER (TCP_SEND_BUFFER_SIZE * 3 / 4) // A client is congested above this, until its queue is below half of it
+#endif
+
+#ifndef TCP_COALESCE_THRESHOLD
+#define TCP_COALESCE_THRESHOLD 512 // Coalesced writes go once this much is queued
+#endif
+
 class DashioTCP {
 private:
+    // Each client has its own parser, so messages from different dashboards can't be mixed up
+    struct TCPClient {
+        WiFiClient client;
+        MessageData messageData;
+        String dashboardID = ((char *)0); // From the client's last config request
+        int configPagePos = -1; // Position of the next config page to send, or -1 when not sending config
+        bool active = false;
+        char sendBuffer[TCP_SEND_BUFFER_SIZE];
+        SendQueue sendQueue;
+        bool congested = false;
+        unsigned long firstQueuedTime = 0; // When the oldest queued message was added
+        unsigned long lastReceivedTime = 0;
+        unsigned long lastHeartbeatTime = 0;
+        bool heartbeatPending = false; // Sent a heartbeat, and nothing has been received since
+
+        TCPClient() : messageData(TCP_CONN), sendQueue(sendBuffer, TCP_SEND_BUFFER_SIZE) {}
+    };
+
     bool printMessages;
     DashioDevice *dashioDevice;
-    MessageData messageData;
     uint16_t tcpPort = 5000;
-    WiFiClient client;
+    TCPClient clients[TCP_MAX_CLIENTS];
     WiFiServer wifiServer;
 /*???
     WiFiUDP udp;
@@ -70,11 +103,38 @@ private:
 */
 
     void (*processTCPmessageCallback)(MessageData *connection);
+    void (*backpressureCallback)(int clientIndex, bool congested) = NULL;
+    unsigned long coalesceWindow = 0;
+    size_t coalesceThreshold = TCP_COALESCE_THRESHOLD;
+    unsigned long idleTimeout = 0;
+    unsigned long heartbeatInterval = 0;
+
+    void addClient(WiFiClient& newClient);
+    void removeClient(int clientIndex);
+    void processMessage(int clientIndex);
+    void sendConfigPage(int clientIndex);
+    void queueMessage(int clientIndex, const char *message, size_t messageLength);
+    void sendQueued(int clientIndex);
+    bool readyToSend(int clientIndex);
+    void checkBackpressure(int clientIndex);
+    bool checkIdle(int clientIndex);
 
 public:
+    int currentClient = -1; // The client whose message is being processed, e.g. to reply with sendMessage(message, tcp_con.currentClient)
+    unsigned int droppedMessages = 0; // Messages not sent because a client's send queue was full, or they were larger than it
+    unsigned long messagesSent = 0; // Counted once for each client a message goes to
+    unsigned long segmentsSent = 0; // Socket writes. Each is usually one TCP segment
+
     DashioTCP(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages = false);
     void setCallback(void (*processIncomingMessage)(MessageData *connection));
-    void sendMessage(const String& message);
+    void setBackpressureCallback(void (*_backpressureCallback)(int clientIndex, bool congested));
+    void sendMessage(const String& message); // To the client whose message is being processed, or to every client outside the callback
+    void sendMessage(const String& message, int clientIndex); // To one client
+    void sendMessageToAll(const String& message); // To every client, e.g. a value that every dashboard shows
+    int numClients();
+    bool isCongested(); // True while any client's send queue is above TCP_SEND_HIGH_WATER
+    void setCoalescing(unsigned long windowMs, size_t threshold = TCP_COALESCE_THRESHOLD); // A windowMs of 0 turns it off
+    void setIdleTimeout(unsigned long timeoutMs, unsigned long heartbeatMs = 0); // Removes a client that is silent for timeoutMs after a heartbeat. A heartbeatMs of 0 uses timeoutMs
     void begin();
     void end();
     void run();
@@ -87,7 +147,7 @@ private:
     bool reboot = true;
     bool printMessages;
     DashioDevice *dashioDevice;
-    static MessageData messageData;
+    static QueuedMessageData messageData;
     static WiFiSSLClient wifiClient;
     static MqttClient mqttClient;
     int mqttConnectCount = 0;
@@ -143,7 +203,7 @@ class DashioBLE {
 private:
     bool printMessages;
     DashioDevice *dashioDevice;
-    static MessageData messageData;
+    static QueuedMessageData messageData;
     BLEService bleService;
     BLECharacteristic bleCharacteristic;
 
@@ -0,0 +1,199 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+#if !defined ARDUINO && (defined __unix__ || defined __APPLE__)
+
+#include "DashioSocket.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+    #include <sys/epoll.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS uses SO_NOSIGPIPE instead
+#endif
+
+static bool setNonBlocking(int socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    return (flags >= 0) && (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+static bool wouldBlock() {
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+}
+
+int socketListen(uint16_t port, int backlog) {
+    int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (serverSocket < 0) {
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)); // So a restarted test can take the port straight away
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if ((bind(serverSocket, (struct sockaddr *)&address, sizeof(address)) < 0) || (listen(serverSocket, backlog) < 0) || !setNonBlocking(serverSocket)) {
+        close(serverSocket);
+        return -1;
+    }
+    return serverSocket;
+}
+
+// Non-blocking, and small writes aren't held back, as the transport coalesces them itself when asked to
+static bool setupClientSocket(int clientSocket) {
+    if (!setNonBlocking(clientSocket)) {
+        return false;
+    }
+
+    int noDelay = 1;
+    setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+    return true;
+}
+
+int socketAccept(int serverSocket) {
+    int clientSocket = accept(serverSocket, NULL, NULL);
+    if (clientSocket < 0) {
+        return -1;
+    }
+    if (!setupClientSocket(clientSocket)) {
+        close(clientSocket);
+        return -1;
+    }
+    return clientSocket;
+}
+
+int socketConnect(const char *host, uint16_t port) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char portStr[6];
+    snprintf(portStr, sizeof(portStr), "%u", port);
+
+    struct addrinfo *addresses;
+    if (getaddrinfo(host, portStr, &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int clientSocket = -1;
+    for (struct addrinfo *address = addresses; address != NULL; address = address->ai_next) {
+        clientSocket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (clientSocket < 0) {
+            continue;
+        }
+        if ((connect(clientSocket, address->ai_addr, address->ai_addrlen) == 0) && setupClientSocket(clientSocket)) {
+            break;
+        }
+        close(clientSocket);
+        clientSocket = -1;
+    }
+    freeaddrinfo(addresses);
+    return clientSocket;
+}
+
+long socketSend(int socket, const char *data, size_t dataLength) {
+    ssize_t sent = send(socket, data, dataLength, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0) {
+        return wouldBlock() ? SOCKET_WOULD_BLOCK : -1;
+    }
+    return sent;
+}
+
+long socketReceive(int socket, char *buffer, size_t bufferSize) {
+    ssize_t received = recv(socket, buffer, bufferSize, 0);
+    if (received < 0) {
+        return wouldBlock() ? SOCKET_WOULD_BLOCK : -1;
+    }
+    return received;
+}
+
+void socketClose(int socket) {
+    close(socket);
+}
+
+#ifdef __linux__
+const int SOCKET_POLL_MAX_EVENTS = 64;
+
+int socketPollCreate() {
+    return epoll_create1(0);
+}
+
+bool socketPollAdd(int pollSocket, int socket, int tag) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = tag;
+    return epoll_ctl(pollSocket, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+bool socketPollSetWritable(int pollSocket, int socket, int tag, bool writable) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    if (writable) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = tag;
+    return epoll_ctl(pollSocket, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+void socketPollRemove(int pollSocket, int socket) {
+    epoll_ctl(pollSocket, EPOLL_CTL_DEL, socket, NULL);
+}
+
+int socketPollWait(int pollSocket, SocketEvent events[], int maxEvents, int timeoutMs) {
+    struct epoll_event pollEvents[SOCKET_POLL_MAX_EVENTS];
+    int numEvents = epoll_wait(pollSocket, pollEvents, (maxEvents < SOCKET_POLL_MAX_EVENTS) ? maxEvents : SOCKET_POLL_MAX_EVENTS, timeoutMs);
+    if (numEvents < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    for (int i = 0; i < numEvents; i++) {
+        events[i].tag = pollEvents[i].data.fd;
+        events[i].readable = (pollEvents[i].events & EPOLLIN) != 0;
+        events[i].writable = (pollEvents[i].events & EPOLLOUT) != 0;
+        events[i].closed = (pollEvents[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+    }
+    return numEvents;
+}
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Thin wrappers around non-blocking POSIX sockets for the host transports and test drivers. They are kept out of
+// DashioPOSIX.cpp because the system socket headers declare connect(), which clashes with the connect ControlType in
+// DashIO.h. Code that includes DashIO.h should use these instead of including the socket headers.
+#if !defined ARDUINO && (defined __unix__ || defined __APPLE__)
+
+#ifndef DashioSocket_h
+#define DashioSocket_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SOCKET_WOULD_BLOCK -2 // Returned by socketSend and socketReceive when the socket isn't ready
+
+int socketListen(uint16_t port, int backlog); // Returns the non-blocking listening socket, or -1
+int socketAccept(int serverSocket); // Returns a non-blocking client socket, or -1 when none are waiting
+int socketConnect(const char *host, uint16_t port); // Returns a non-blocking socket connected to host, or -1. Waits for the connection
+long socketSend(int socket, const char *data, size_t dataLength); // Bytes sent, SOCKET_WOULD_BLOCK, or -1 on error
+long socketReceive(int socket, char *buffer, size_t bufferSize); // Bytes read, 0 once closed, SOCKET_WOULD_BLOCK, or -1 on error
+void socketClose(int socket);
+
+#ifdef __linux__
+// epoll, level triggered. The tag identifies the socket in the events.
+struct SocketEvent {
+    int tag;
+    bool readable;
+    bool writable;
+    bool closed; // Hung up or failed. Anything still readable should be read first
+};
+
+int socketPollCreate(); // Returns -1 on error
+bool socketPollAdd(int pollSocket, int socket, int tag);
+bool socketPollSetWritable(int pollSocket, int socket, int tag, bool writable); // Whether to also report when the socket can be written to
+void socketPollRemove(int pollSocket, int socket);
+int socketPollWait(int pollSocket, SocketEvent events[], int maxEvents, int timeoutMs); // Returns the number of events, or -1 on error
+#endif
+
+#endif
+#endif
@@ -0,0 +1,40 @@
+/*
+ MIT License
+
+ Copyright (c) 2021 Craig Tuffnell, DashIO Connect Limited
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+
+// Non-blocking writes to a WiFiClient's socket on the ESP32. Kept out of DashioESP.cpp because lwip's socket header
+// declares connect(), which clashes with the connect ControlType in DashIO.h.
+#ifdef ESP32
+
+#ifndef DashioSocketESP32_h
+#define DashioSocketESP32_h
+
+#include <stddef.h>
+
+#define SOCKET_WOULD_BLOCK -2 // Returned by socketSend when the socket can't take any more yet
+
+long socketSend(int socket, const char *data, size_t dataLength); // Bytes sent, SOCKET_WOULD_BLOCK, or -1 on error
+
+#endif
+#endif
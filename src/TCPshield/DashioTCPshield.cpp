@@ -26,7 +26,9 @@
 
 #include "DashioTCPshield.h"
 
-DashioTCPshield::DashioTCPshield(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : server(_tcpPort), dashioConnection(TCP_CONN) {
+const int TCP_READ_CHUNK_LENGTH = 32; // Bytes read from the Ethernet chip at a time. Kept small for the AVR's RAM
+
+DashioTCPshield::DashioTCPshield(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages) : server(_tcpPort) {
     dashioDevice = _dashioDevice;
     printMessages = _printMessages;
 }
@@ -35,9 +37,23 @@ void DashioTCPshield::setCallback(void (*processIncomingMessage)(MessageData *me
     processTCPmessageCallback = processIncomingMessage;
 }
 
+// In the callback this is a reply, e.g. to STATUS, so it goes only to the client that asked
 void DashioTCPshield::sendMessage(const String& message) {
-    if (alreadyConnected) {
-        server.print(message);
+    if (currentClient >= 0) {
+        sendMessage(message, currentClient);
+    } else {
+        sendMessageToAll(message);
+    }
+}
+
+void DashioTCPshield::sendMessageToAll(const String& message) {
+    if (numClients() > 0) {
+        if (coalesceWindow > 0) {
+            coalesceMessage(message.c_str(), message.length());
+        } else {
+            writeToClients(message.c_str(), message.length());
+        }
+        messagesSent++;
 
         if (printMessages) {
             Serial.println(F("---- TCP Sent ----"));
@@ -47,6 +63,79 @@ void DashioTCPshield::sendMessage(const String& message) {
     }
 }
 
+// Coalesced writes go first, so that the client receives messages in the order they were sent
+void DashioTCPshield::sendMessage(const String& message, int clientIndex) {
+    if ((clientIndex < 0) || (clientIndex >= TCP_MAX_CLIENTS)) {
+        return;
+    }
+    TCPClient& tcpClient = clients[clientIndex];
+    if (tcpClient.active && tcpClient.client.connected()) {
+        flush();
+        tcpClient.client.write((const uint8_t *)message.c_str(), message.length());
+        messagesSent++;
+        segmentsSent++;
+
+        if (printMessages) {
+            Serial.print(F("---- TCP Sent ---- Client: "));
+            Serial.println(clientIndex);
+            Serial.println(message);
+            Serial.println();
+        }
+    }
+}
+
+int DashioTCPshield::numClients() {
+    int count = 0;
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void DashioTCPshield::setCoalescing(unsigned long windowMs, size_t threshold) {
+    flush();
+    coalesceWindow = windowMs;
+    coalesceThreshold = min(threshold, (size_t)TCP_COALESCE_BUFFER_SIZE);
+}
+
+// Held until the threshold is reached or the first held message has waited for the window
+void DashioTCPshield::coalesceMessage(const char *message, size_t messageLength) {
+    if (coalesceLength + messageLength > TCP_COALESCE_BUFFER_SIZE) {
+        flush();
+        if (messageLength > TCP_COALESCE_BUFFER_SIZE) {
+            writeToClients(message, messageLength);
+            return;
+        }
+    }
+
+    if (coalesceLength == 0) {
+        firstCoalescedTime = millis();
+    }
+    memcpy(coalesceBuffer + coalesceLength, message, messageLength);
+    coalesceLength += messageLength;
+    if (coalesceLength >= coalesceThreshold) {
+        flush();
+    }
+}
+
+void DashioTCPshield::flush() {
+    if (coalesceLength > 0) {
+        writeToClients(coalesceBuffer, coalesceLength);
+        coalesceLength = 0;
+    }
+}
+
+void DashioTCPshield::writeToClients(const char *data, size_t dataLength) {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && clients[i].client.connected()) {
+            clients[i].client.write((const uint8_t *)data, dataLength);
+            segmentsSent++;
+        }
+    }
+}
+
 void DashioTCPshield::begin(byte mac[]) {
     Ethernet.begin(mac); // start listening for clients
     server.begin(); // Open serial communications and wait for port to open:
@@ -55,41 +144,107 @@ void DashioTCPshield::begin(byte mac[]) {
     Serial.println(Ethernet.localIP());
 }
 
+// EthernetServer::available() returns any client with data waiting, so it may be one that is already in the table
+void DashioTCPshield::addClient(EthernetClient& newClient) {
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && (clients[i].client == newClient)) {
+            return;
+        }
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (!clients[i].active) {
+            clients[i].client = newClient;
+            clients[i].client.setTimeout(2000);
+            clients[i].dashioConnection.reset();
+            clients[i].active = true;
+
+            if (printMessages) {
+                Serial.print(F("TCP client connected: "));
+                Serial.println(i);
+            }
+            return;
+        }
+    }
+
+    newClient.stop(); // All the slots are in use
+    if (printMessages) {
+        Serial.println(F("TCP client refused"));
+    }
+}
+
+void DashioTCPshield::removeClient(int clientIndex) {
+    clients[clientIndex].client.stop();
+    clients[clientIndex].active = false;
+
+    if (printMessages) {
+        Serial.print(F("TCP client disconnected: "));
+        Serial.println(clientIndex);
+    }
+}
+
 void DashioTCPshield::run() {
-  // wait for a new client:
-    EthernetClient client = server.available();
-    client.setTimeout(2000);
-
-    if (client) {
-        if (!alreadyConnected) {
-            client.flush();  // clear out the input buffer:
-            Serial.println("Connected");
-            alreadyConnected = true;
+    if ((coalesceLength > 0) && (millis() - firstCoalescedTime >= coalesceWindow)) {
+        flush();
+    }
+
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        if (clients[i].active && !clients[i].client.connected()) {
+            removeClient(i);
         }
-    
-        while(client.available()) {
-            char data;
-            data = (char)client.read();
-      
-            if (dashioConnection.processChar(data)) {
-                if (printMessages) {
-                    Serial.println(dashioConnection.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(dashioConnection.control)));
-                }
-    
-                switch (dashioConnection.control) {
-                case who:
-                    sendMessage(dashioDevice->getWhoMessage());
-                    break;
-                case connect:
-                    sendMessage(dashioDevice->getConnectMessage());
-                    break;
-                default:
-                    processTCPmessageCallback(&dashioConnection);
-                    break;
+    }
+
+    EthernetClient newClient = server.available();
+    if (newClient) {
+        addClient(newClient);
+    }
+
+    char readBuffer[TCP_READ_CHUNK_LENGTH];
+    for (int i = 0; i < TCP_MAX_CLIENTS; i++) {
+        TCPClient& tcpClient = clients[i];
+        if (!tcpClient.active) {
+            continue;
+        }
+
+        while (tcpClient.client.available()) {
+            int readLength = tcpClient.client.read((uint8_t *)readBuffer, TCP_READ_CHUNK_LENGTH);
+            if (readLength <= 0) {
+                break;
+            }
+            for (int j = 0; j < readLength; j++) {
+                if (tcpClient.dashioConnection.processChar(readBuffer[j])) {
+                    processMessage(i);
                 }
             }
         }
     }
 }
 
+// Replies to WHO, CONNECT and config go only to the client that asked
+void DashioTCPshield::processMessage(int clientIndex) {
+    MessageData& dashioConnection = clients[clientIndex].dashioConnection;
+    if (printMessages) {
+        Serial.println(dashioConnection.getReceivedMessageForPrint(dashioDevice->getControlTypeStr(dashioConnection.control)));
+    }
+
+    currentClient = clientIndex;
+    switch (dashioConnection.control) {
+    case who:
+        sendMessage(dashioDevice->getWhoMessage(), clientIndex);
+        break;
+    case connect:
+        sendMessage(dashioDevice->getConnectMessage(), clientIndex);
+        break;
+    default:
+        String configReply((char *)0);
+        if (dashioDevice->handleConfigRequest(dashioConnection, configReply)) { // Reply from the config snapshot instead of the callback
+            sendMessage(configReply, clientIndex);
+            break;
+        }
+        processTCPmessageCallback(&dashioConnection);
+        break;
+    }
+    currentClient = -1;
+}
+
 #endif
@@ -31,19 +31,55 @@
 #include <Ethernet.h>
 #include "DashIO.h"
 
+#ifndef TCP_MAX_CLIENTS
+#define TCP_MAX_CLIENTS 2 // Dashboards that can be connected at the same time. The W5100 has 4 sockets
+#endif
+
+#ifndef TCP_COALESCE_BUFFER_SIZE
+#define TCP_COALESCE_BUFFER_SIZE 128 // Holds writes while coalescing
+#endif
+
 class DashioTCPshield {
 private:
+    // Each client has its own parser, so messages from different dashboards can't be mixed up
+    struct TCPClient {
+        EthernetClient client;
+        MessageData dashioConnection;
+        bool active = false;
+
+        TCPClient() : dashioConnection(TCP_CONN) {}
+    };
+
     bool printMessages = false;
     DashioDevice *dashioDevice;
-    MessageData dashioConnection;
+    TCPClient clients[TCP_MAX_CLIENTS];
     EthernetServer server;
-    boolean alreadyConnected = false; // whether or not the client was connected previously
     void (*processTCPmessageCallback)(MessageData *messageData);
+    char coalesceBuffer[TCP_COALESCE_BUFFER_SIZE];
+    size_t coalesceLength = 0;
+    size_t coalesceThreshold = TCP_COALESCE_BUFFER_SIZE;
+    unsigned long coalesceWindow = 0;
+    unsigned long firstCoalescedTime = 0;
+
+    void addClient(EthernetClient& newClient);
+    void removeClient(int clientIndex);
+    void processMessage(int clientIndex);
+    void coalesceMessage(const char *message, size_t messageLength);
+    void writeToClients(const char *data, size_t dataLength);
 
 public:
+    int currentClient = -1; // The client whose message is being processed, e.g. to reply with sendMessage(message, tcp.currentClient)
+    unsigned long messagesSent = 0;
+    unsigned long segmentsSent = 0; // Server writes. Each is usually one TCP segment
+
     DashioTCPshield(DashioDevice *_dashioDevice, uint16_t _tcpPort, bool _printMessages = false);
     void setCallback(void (*processIncomingMessage)(MessageData *messageData));
-    void sendMessage(const String& message);
+    void sendMessage(const String& message); // To the client whose message is being processed, or to every client outside the callback
+    void sendMessage(const String& message, int clientIndex); // To one client
+    void sendMessageToAll(const String& message); // To every client, e.g. a value that every dashboard shows
+    int numClients();
+    void setCoalescing(unsigned long windowMs, size_t threshold = TCP_COALESCE_BUFFER_SIZE); // A windowMs of 0 turns it off
+    void flush(); // Sends coalesced writes now
     void begin(byte mac[]);
     void run();
 